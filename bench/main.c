@@ -0,0 +1,288 @@
+#include <haxxor.h>
+#include <hxmath.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAXIMUM_SPRITES 1000000
+#define MAXIMUM_BENCH_TEXTURES 256
+#define MAXIMUM_BENCH_LAYERS ((MAXIMUM_SPRITES + MAXIMUM_QUADS - 1) / MAXIMUM_QUADS)
+
+typedef struct Bench {
+	int Sprites;
+	int Frames;
+	int TexturesCount;
+	TEXTURE2D Textures[MAXIMUM_BENCH_TEXTURES];
+	STATIC_LAYER* Layers[MAXIMUM_BENCH_LAYERS];
+	int LayersCount;
+	SPATIAL_GRID* Grid;
+	COMMAND_BUFFER* Commands;
+	SPRITE_SHEET* Sheet;
+	ANIMATOR* Animator;
+} Bench;
+
+typedef struct Scenario {
+	const char* Name;
+	void (*Draw)(const Bench* bench);
+} Scenario;
+
+static RECTANGLE rects[MAXIMUM_SPRITES];
+static COLOR colors[MAXIMUM_SPRITES];
+
+// Entity state for the soa scenario
+static struct {
+	float X[MAXIMUM_SPRITES], Y[MAXIMUM_SPRITES];
+	float VelocityX[MAXIMUM_SPRITES], VelocityY[MAXIMUM_SPRITES];
+	float HalfW[MAXIMUM_SPRITES], HalfH[MAXIMUM_SPRITES], W[MAXIMUM_SPRITES], H[MAXIMUM_SPRITES];
+	float MinX[MAXIMUM_SPRITES], MinY[MAXIMUM_SPRITES], MaxX[MAXIMUM_SPRITES], MaxY[MAXIMUM_SPRITES];
+	int Visible[MAXIMUM_SPRITES];
+	RECTANGLE Rects[MAXIMUM_SPRITES];
+} soa;
+
+static void DrawSolid(const Bench* bench)
+{
+	for(int i = 0; i < bench->Sprites; i++) DrawRectangle(rects[i], colors[i]);
+}
+
+static void DrawTextured(const Bench* bench)
+{
+	for(int i = 0; i < bench->Sprites; i++) DrawRectangleTex(rects[i], bench->Textures[i % bench->TexturesCount]);
+}
+
+// Blend mode changes every 256 sprites and solid and textured sprites interleave
+static void DrawMixed(const Bench* bench)
+{
+	for(int i = 0; i < bench->Sprites; i++)
+	{
+		if(i % 256 == 0) SetBlendMode((i / 256) % 2 ? BLEND_ADDITIVE : BLEND_ALPHA);
+		if(i % 2) DrawRectangle(rects[i], colors[i]);
+		else DrawRectangleTex(rects[i], bench->Textures[(i / 2) % bench->TexturesCount]);
+	}
+	SetBlendMode(BLEND_ALPHA);
+}
+
+// Cycles through every loaded texture so the batch runs out of texture slots over and over
+static void DrawOverflow(const Bench* bench)
+{
+	for(int i = 0; i < bench->Sprites; i++) DrawRectangleTex(rects[i], bench->Textures[i % MAXIMUM_BENCH_TEXTURES]);
+}
+
+static void DrawBulkSolid(const Bench* bench)
+{
+	DrawRectangles(rects, colors, bench->Sprites);
+}
+
+// Same sprites as textured, drawn as one run per texture
+static void DrawBulkTextured(const Bench* bench)
+{
+	int run = (bench->Sprites + bench->TexturesCount - 1) / bench->TexturesCount;
+	for(int first = 0, t = 0; first < bench->Sprites; first += run, t++)
+	{
+		int count = bench->Sprites - first < run ? bench->Sprites - first : run;
+		DrawRectanglesTex(rects + first, count, bench->Textures[t]);
+	}
+}
+
+// The textured sprites recorded once into static layers, one tile changes every frame
+static void DrawStatic(const Bench* bench)
+{
+	static int frame = 0;
+	int tile = frame++ % (bench->Sprites < MAXIMUM_QUADS ? bench->Sprites : MAXIMUM_QUADS);
+	SetStaticRectangle(bench->Layers[0], tile, rects[tile], colors[tile]);
+	for(int i = 0; i < bench->LayersCount; i++) DrawStaticLayer(bench->Layers[i]);
+}
+
+// Zoomed in on the middle of the screen, three quarters of the sprites are culled
+static void DrawCamera(const Bench* bench)
+{
+	BeginCamera((CAMERA2D){ 640.0f, 360.0f, 640.0f, 360.0f, 0.0f, 2.0f });
+	DrawTextured(bench);
+	EndCamera();
+}
+
+// Same view as camera, but only the sprites the grid reports are submitted
+static void DrawGrid(const Bench* bench)
+{
+	static int visible[MAXIMUM_SPRITES];
+	BeginCamera((CAMERA2D){ 640.0f, 360.0f, 640.0f, 360.0f, 0.0f, 2.0f });
+	int count = QueryGrid(bench->Grid, GetCameraView(), visible, MAXIMUM_SPRITES);
+	for(int i = 0; i < count; i++) DrawRectangleTex(rects[visible[i]], bench->Textures[visible[i] % bench->TexturesCount]);
+	EndCamera();
+}
+
+// Recorded into a command buffer over 4 layers, EndDraw sorts it by layer, texture and y
+static void DrawRecorded(const Bench* bench)
+{
+	SetCommandSorting(true);
+	for(int i = 0; i < bench->Sprites; i++)
+		RecordRectangleTex(bench->Commands, rects[i], bench->Textures[i % bench->TexturesCount], (RECTANGLE){ 0.0f, 0.0f, 1.0f, 1.0f }, i % 4, rects[i].y);
+	SubmitCommandBuffer(bench->Commands);
+}
+
+// The textured sprites spinning around their centres, the rotation is applied by the vertex shader in instanced mode
+static void DrawRotated(const Bench* bench)
+{
+	static int frame = 0;
+	float spin = 0.01f * (float)frame++;
+	for(int i = 0; i < bench->Sprites; i++)
+	{
+		TRANSFORM2D transform = { 4.0f, 4.0f, spin + 0.001f * (float)i, 1.0f, 1.0f };
+		DrawRectangleTexPro(rects[i], bench->Textures[i % bench->TexturesCount], (RECTANGLE){ 0.0f, 0.0f, 1.0f, 1.0f }, transform);
+	}
+}
+
+// Every sprite animated from a 4x4 sheet, the instance shader looks the frame UVs up
+static void DrawAnimated(const Bench* bench)
+{
+	UpdateAnimator(bench->Animator, 1.0f / 60.0f);
+	DrawAnimator(bench->Animator, rects);
+}
+
+// Moved, bounded and tested against the screen as float arrays, only the visible sprites reach DrawRectangles
+static void DrawSoa(const Bench* bench)
+{
+	SoaIntegrate(soa.X, soa.Y, soa.VelocityX, soa.VelocityY, 1.0f / 60.0f, bench->Sprites);
+	SoaAabbs(soa.MinX, soa.MinY, soa.MaxX, soa.MaxY, soa.X, soa.Y, soa.HalfW, soa.HalfH, bench->Sprites);
+	int count = SoaOverlapRect(soa.Visible, soa.MinX, soa.MinY, soa.MaxX, soa.MaxY, 0.0f, 0.0f, 1280.0f, 720.0f, bench->Sprites);
+	SoaToRects(&soa.Rects[0].x, soa.MinX, soa.MinY, soa.W, soa.H, soa.Visible, count);
+	DrawRectangles(soa.Rects, colors, count);
+}
+
+static const Scenario scenarios[] = {
+	{ "solid", DrawSolid },
+	{ "textured", DrawTextured },
+	{ "mixed", DrawMixed },
+	{ "overflow", DrawOverflow },
+	{ "bulk", DrawBulkSolid },
+	{ "bulk-textured", DrawBulkTextured },
+	{ "static", DrawStatic },
+	{ "camera", DrawCamera },
+	{ "grid", DrawGrid },
+	{ "recorded", DrawRecorded },
+	{ "rotated", DrawRotated },
+	{ "animated", DrawAnimated },
+	{ "soa", DrawSoa },
+};
+
+static void RunScenario(const Bench* bench, const Scenario* scenario, BATCH_MODE mode)
+{
+	SetBatchMode(mode);
+	double draw = 0.0;
+	double transfer = 0.0;
+	double endDraw = 0.0;
+	double start = GetTime();
+	for(int frame = 0; frame < bench->Frames; frame++)
+	{
+		PollEvents();
+		BeginDraw();
+		double t = GetTime();
+		scenario->Draw(bench);
+		draw += GetTime() - t;
+		EndDraw();
+		FRAME_PROFILE profile = GetFrameProfile(0);
+		transfer += profile.Milliseconds[PROFILE_TRANSFER];
+		endDraw += profile.Milliseconds[PROFILE_END_DRAW];
+	}
+	double total = GetTime() - start;
+	RENDER_STATS stats = GetFrameProfile(0).Stats;
+
+	char name[64];
+	snprintf(name, sizeof(name), "%s %s", scenario->Name, mode == BATCH_MODE_INSTANCED ? "instanced" : "vertices");
+	printf("%-20s %8.2f ns/quad %8.3f ms transfer %8.3f ms EndDraw %8.1f fps %6u draws %6u flushes %7u culled", name,
+		draw / ((double)bench->Frames * bench->Sprites) * 1e9, transfer / bench->Frames, endDraw / bench->Frames,
+		bench->Frames / total, stats.DrawCalls, stats.Flushes, stats.Culled);
+	// Deterministic on llvmpipe, a changed checksum means the scenario no longer draws the same frame
+	if(IsHeadless()) printf(" %016llx", (unsigned long long)GetFrameChecksum());
+	printf("\n");
+}
+
+int main(int argc, char** argv)
+{
+	const float SCREEN_WIDTH = 1280.0f;
+	const float SCREEN_HEIGHT = 720.0f;
+	Bench bench = { .Sprites = 100000, .Frames = 120, .TexturesCount = 8 };
+	const char* only = NULL;
+	const char* trace = NULL;
+	for(int i = 1; i < argc; i++)
+	{
+		if(strcmp(argv[i], "-n") == 0 && i + 1 < argc) bench.Sprites = atoi(argv[++i]);
+		else if(strcmp(argv[i], "-k") == 0 && i + 1 < argc) bench.TexturesCount = atoi(argv[++i]);
+		else if(strcmp(argv[i], "-frames") == 0 && i + 1 < argc) bench.Frames = atoi(argv[++i]);
+		else if(strcmp(argv[i], "-trace") == 0 && i + 1 < argc) trace = argv[++i];
+		else if(argv[i][0] != '-') only = argv[i];
+		else
+		{
+			fprintf(stderr, "usage: %s [-n sprites] [-k textures] [-frames count] [-trace file.json] [scenario]\n", argv[0]);
+			return -1;
+		}
+	}
+	if(bench.Sprites < 1 || bench.Sprites > MAXIMUM_SPRITES) bench.Sprites = MAXIMUM_SPRITES;
+	if(bench.TexturesCount < 1 || bench.TexturesCount > MAXIMUM_BENCH_TEXTURES) bench.TexturesCount = MAXIMUM_BENCH_TEXTURES;
+	if(bench.Frames < 1) bench.Frames = 1;
+
+	if(!InitHaxxor("Haxxor Bench", SCREEN_WIDTH, SCREEN_HEIGHT)) return -1;
+	SetProfiling(true);
+
+	srand(1234);
+	for(int i = 0; i < bench.Sprites; i++)
+	{
+		rects[i] = (RECTANGLE){ (float)(rand() % (int)SCREEN_WIDTH), (float)(rand() % (int)SCREEN_HEIGHT), 8.0f, 8.0f };
+		colors[i] = (COLOR){ (uint8_t)(rand() % 256), (uint8_t)(rand() % 256), (uint8_t)(rand() % 256), 255 };
+		soa.X[i] = rects[i].x + 4.0f;
+		soa.Y[i] = rects[i].y + 4.0f;
+		soa.VelocityX[i] = (float)(rand() % 121 - 60);
+		soa.VelocityY[i] = (float)(rand() % 121 - 60);
+		soa.HalfW[i] = soa.HalfH[i] = 4.0f;
+		soa.W[i] = soa.H[i] = 8.0f;
+	}
+
+	for(int t = 0; t < MAXIMUM_BENCH_TEXTURES; t++)
+	{
+		// DestroyImage frees the pixels
+		uint8_t* pixels = malloc(4 * 4 * 4);
+		for(int i = 0; i < 4 * 4; i++)
+		{
+			pixels[i * 4 + 0] = (uint8_t)(t * 37);
+			pixels[i * 4 + 1] = (uint8_t)(t * 91);
+			pixels[i * 4 + 2] = (uint8_t)(255 - t);
+			pixels[i * 4 + 3] = 255;
+		}
+		IMAGE* img = LoadImage(pixels, 4, 4);
+		bench.Textures[t] = LoadTextureFromImage(img);
+		DestroyImage(img);
+	}
+
+	for(int i = 0; i < bench.Sprites; i++)
+	{
+		if(i % MAXIMUM_QUADS == 0) bench.Layers[bench.LayersCount++] = LoadStaticLayer(MAXIMUM_QUADS);
+		AddStaticRectangleTex(bench.Layers[bench.LayersCount - 1], rects[i], bench.Textures[i % bench.TexturesCount], (RECTANGLE){ 0.0f, 0.0f, 1.0f, 1.0f });
+	}
+
+	bench.Sheet = LoadSpriteSheetGrid(bench.Textures[0], 4, 4);
+	int walk = AddSpriteAnimation(bench.Sheet, 0, 8, 12.0f, true);
+	int run = AddSpriteAnimation(bench.Sheet, 8, 8, 24.0f, true);
+	bench.Animator = LoadAnimator(bench.Sheet, bench.Sprites);
+	for(int i = 0; i < bench.Sprites; i++) AddAnimationInstance(bench.Animator, i % 2 ? run : walk);
+
+	bench.Commands = LoadCommandBuffer();
+	bench.Grid = LoadSpatialGrid(64.0f);
+	for(int i = 0; i < bench.Sprites; i++) AddGridObject(bench.Grid, rects[i], i);
+
+	printf("%d sprites, %d textures, %d frames per scenario%s\n", bench.Sprites, bench.TexturesCount, bench.Frames, IsHeadless() ? ", headless" : "");
+	for(int i = 0; i < (int)(sizeof(scenarios) / sizeof(scenarios[0])); i++)
+	{
+		if(only && strcmp(only, scenarios[i].Name) != 0) continue;
+		RunScenario(&bench, &scenarios[i], BATCH_MODE_VERTICES);
+		RunScenario(&bench, &scenarios[i], BATCH_MODE_INSTANCED);
+	}
+
+	if(trace && !ExportProfileTrace(trace)) fprintf(stderr, "Failed to write %s\n", trace);
+	for(int i = 0; i < bench.LayersCount; i++) DestroyStaticLayer(bench.Layers[i]);
+	DestroySpatialGrid(bench.Grid);
+	DestroyCommandBuffer(bench.Commands);
+	DestroyAnimator(bench.Animator);
+	DestroySpriteSheet(bench.Sheet);
+	ShutHaxxor();
+	return 0;
+}
@@ -0,0 +1,138 @@
+#include <hxmath.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Precision and throughput of the hxmath fast tier against libm, no window needed, exits with 1 when a matrix path is wrong
+#define SAMPLES (1 << 20)
+
+static float inputs[SAMPLES];
+static float outSin[SAMPLES];
+static float outCos[SAMPLES];
+
+static double Now()
+{
+	struct timespec t;
+	timespec_get(&t, TIME_UTC);
+	return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+static void FillInputs(float range)
+{
+	for(int i = 0; i < SAMPLES; i++) inputs[i] = ((float)rand() / (float)RAND_MAX * 2.0f - 1.0f) * range;
+}
+
+static void LibmSinCosArray(float* s, float* c, const float* x, int count)
+{
+	for(int i = 0; i < count; i++)
+	{
+		s[i] = sinf(x[i]);
+		c[i] = cosf(x[i]);
+	}
+}
+
+static void LibmRsqrtArray(float* out, const float* x, int count)
+{
+	for(int i = 0; i < count; i++) out[i] = 1.0f / sqrtf(x[i]);
+}
+
+static void FastRsqrtArray(float* out, const float* x, int count)
+{
+	for(int i = 0; i < count; i++) out[i] = FastRsqrt(x[i]);
+}
+
+static void SinCosPrecision(float range)
+{
+	FillInputs(range);
+	SinCosArray(outSin, outCos, inputs, SAMPLES);
+	double worst = 0.0;
+	for(int i = 0; i < SAMPLES; i++)
+	{
+		double s = fabs(outSin[i] - sin((double)inputs[i]));
+		double c = fabs(outCos[i] - cos((double)inputs[i]));
+		if(s > worst) worst = s;
+		if(c > worst) worst = c;
+	}
+	printf("sincos |x| < %-8g max abs error %.3g\n", range, worst);
+}
+
+static void RsqrtPrecision()
+{
+	for(int i = 0; i < SAMPLES; i++) inputs[i] = ldexpf((float)rand() / (float)RAND_MAX + 1.0f, rand() % 80 - 40);
+	FastRsqrtArray(outSin, inputs, SAMPLES);
+	double worst = 0.0;
+	for(int i = 0; i < SAMPLES; i++)
+	{
+		double exact = 1.0 / sqrt((double)inputs[i]);
+		double e = fabs(outSin[i] - exact) / exact;
+		if(e > worst) worst = e;
+	}
+	printf("rsqrt 2^-40..2^40 max rel error %.3g\n", worst);
+}
+
+// Mat4Multiply against the scalar row by column product in double, whichever path hxmath was built with
+static bool MatrixPrecision()
+{
+	double worst = 0.0;
+	for(int t = 0; t < 10000; t++)
+	{
+		MAT4 a, b;
+		for(int i = 0; i < 16; i++)
+		{
+			a.elements[i] = (float)rand() / (float)RAND_MAX * 4.0f - 2.0f;
+			b.elements[i] = (float)rand() / (float)RAND_MAX * 4.0f - 2.0f;
+		}
+		MAT4 m = Mat4Multiply(a, b);
+		for(int i = 0; i < 4; i++)
+		{
+			for(int j = 0; j < 4; j++)
+			{
+				double exact = 0.0;
+				for(int k = 0; k < 4; k++) exact += (double)a.elements[i * 4 + k] * b.elements[k * 4 + j];
+				double e = fabs(m.elements[i * 4 + j] - exact);
+				if(e > worst) worst = e;
+			}
+		}
+	}
+#ifdef HXMATH_SIMD
+	const char* path = "simd";
+#else
+	const char* path = "scalar";
+#endif
+	bool ok = worst < 1e-5;
+	printf("Mat4Multiply (%s) max abs error %.3g%s\n", path, worst, ok ? "" : " MISMATCH");
+	return ok;
+}
+
+static void Throughput(const char* name, void (*fn)(float*, float*, const float*, int), int rounds)
+{
+	double start = Now();
+	for(int r = 0; r < rounds; r++) fn(outSin, outCos, inputs, SAMPLES);
+	printf("%-20s %8.3f ns/value\n", name, (Now() - start) / ((double)rounds * SAMPLES) * 1e9);
+}
+
+static void LibmRsqrt(float* out, float* unused, const float* x, int count) { (void)unused; LibmRsqrtArray(out, x, count); }
+static void FastRsqrtRun(float* out, float* unused, const float* x, int count) { (void)unused; FastRsqrtArray(out, x, count); }
+
+int main(int argc, char** argv)
+{
+	int rounds = argc > 1 ? atoi(argv[1]) : 20;
+	if(rounds < 1) rounds = 1;
+	srand(1234);
+
+	SinCosPrecision(MATH_PI);
+	SinCosPrecision(100.0f);
+	SinCosPrecision(8192.0f);
+	RsqrtPrecision();
+	if(!MatrixPrecision()) return 1;
+
+	FillInputs(100.0f);
+	Throughput("sinf + cosf", LibmSinCosArray, rounds);
+	Throughput("SinCosArray", SinCosArray, rounds);
+	for(int i = 0; i < SAMPLES; i++) inputs[i] = fabsf(inputs[i]) + 1.0f;
+	Throughput("1 / sqrtf", LibmRsqrt, rounds);
+	Throughput("FastRsqrt", FastRsqrtRun, rounds);
+	return 0;
+}
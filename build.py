@@ -161,7 +161,8 @@ if __name__ == "__main__":
 			self.DEFINES += ["_GLFW_X11"]
 			self.LINKS += [
 				"X11",
-				"m" # math
+				"m", # math
+				"pthread" # async loader
 			]
 
 		def on_windows(self):
@@ -181,6 +182,33 @@ if __name__ == "__main__":
 				"_CRT_SECURE_NO_WARNINGS"
 			]
 	
+	# Same library on GLFW's null platform, frames are rendered by OSMesa into an offscreen framebuffer
+	class HaxxorHeadless(Haxxor):
+		def __init__(self):
+			super().__init__()
+			self.NAME = "haxxor_headless"
+			self.DEFINES += ["HAXXOR_HEADLESS"]
+
+		def on_linux(self):
+			self.SOURCES += [
+				Helper.path(self._dependencydir, "src/null_init.c"),
+				Helper.path(self._dependencydir, "src/null_monitor.c"),
+				Helper.path(self._dependencydir, "src/null_window.c"),
+				Helper.path(self._dependencydir, "src/null_joystick.c"),
+				Helper.path(self._dependencydir, "src/posix_time.c"),
+				Helper.path(self._dependencydir, "src/posix_thread.c"),
+				Helper.path(self._dependencydir, "src/osmesa_context.c"),
+			]
+			self.DEFINES += ["_GLFW_OSMESA"]
+			self.LINKS += [
+				"dl", # libOSMesa is loaded at runtime
+				"m", # math
+				"pthread" # async loader
+			]
+
+		def on_windows(self):
+			raise Exception("Headless builds are only supported on Linux")
+
 	class Example(CProject):
 		def __init__(self):
 			super().__init__(
@@ -207,7 +235,8 @@ if __name__ == "__main__":
 		def on_linux(self):
 			self.LINKS += [
 				"X11",
-				"m" # math
+				"m", # math
+				"pthread" # async loader
 			]
 
 		def on_windows(self):
@@ -216,8 +245,129 @@ if __name__ == "__main__":
 				"_CRT_SECURE_NO_WARNINGS"
 			]
 
+	class Bench(CProject):
+		def __init__(self):
+			super().__init__(
+				NAME = "bench",
+				CC = "clang",
+				CFLAGS = "-O2 -Wall -Werror",
+				KIND = CProject.KIND_EXECUTABLE
+			)
+			self.SOURCES += [ Helper.path("bench", "main.c") ]
+
+			self.INCLUDES += [
+				"include",
+				"bench",
+			]
+
+			self.LIBS += [
+				self._targetdir,
+			]
+
+			self.LINKS += [
+				"haxxor"
+			]
+
+		def on_linux(self):
+			self.LINKS += [
+				"X11",
+				"m", # math
+				"pthread" # async loader
+			]
+
+		def on_windows(self):
+			self.DEFINES += [
+				"_GLFW_WIN32",
+				"_CRT_SECURE_NO_WARNINGS"
+			]
+
+	class BenchHeadless(Bench):
+		def __init__(self):
+			super().__init__()
+			self.NAME = "bench_headless"
+
+		def on_linux(self):
+			self.LINKS = [
+				"haxxor_headless",
+				"dl", # libOSMesa is loaded at runtime
+				"m", # math
+				"pthread" # async loader
+			]
+
+		def on_windows(self):
+			raise Exception("Headless builds are only supported on Linux")
+
+	class MathBench(CProject):
+		def __init__(self):
+			super().__init__(
+				NAME = "bench_math",
+				CC = "clang",
+				CFLAGS = "-O2 -Wall -Werror",
+				KIND = CProject.KIND_EXECUTABLE
+			)
+			self.SOURCES += [ Helper.path("bench", "math.c") ]
+
+			self.INCLUDES += [
+				"include",
+			]
+
+		def on_linux(self):
+			self.LINKS += [
+				"m" # math
+			]
+
+		def on_windows(self):
+			self.DEFINES += [
+				"_CRT_SECURE_NO_WARNINGS"
+			]
+
+	class Bake(CProject):
+		def __init__(self):
+			super().__init__(
+				NAME = "bake",
+				CC = "clang",
+				CFLAGS = "-O2 -Wall -Werror",
+				KIND = CProject.KIND_EXECUTABLE
+			)
+			self.SOURCES += [ Helper.path("tools", "bake.c") ]
+
+			self.INCLUDES += [
+				"include",
+				Helper.path(self._dependencydir, "include"),
+			]
+
+		def on_linux(self):
+			self.LINKS += [
+				"m" # math
+			]
+
+		def on_windows(self):
+			self.DEFINES += [
+				"_CRT_SECURE_NO_WARNINGS"
+			]
+
+		# Decodes every image once at build time so the game only has to map the pack
+		def bake(self, target: str, images: list[str], premultiply: bool = False):
+			extension = "exe" if Helper.get_platform() == "Windows" else "out"
+			flags = "-premultiply" if premultiply else ""
+			print(f"({self.NAME}) Baking {target}")
+			os.system(f"{Helper.path(self._targetdir, f'{self.NAME}.{extension}')} {flags} {target} {' '.join(images)}")
+
 	haxxor_project = Haxxor()
 	example_project = Example()
+	bench_project = Bench()
+	bake_project = Bake()
 
 	haxxor_project.build()
-	example_project.build()
\ No newline at end of file
+	if Helper.get_platform() == "Linux":
+		HaxxorHeadless().build()
+	example_project.build()
+	bench_project.build()
+	if Helper.get_platform() == "Linux":
+		BenchHeadless().build()
+	MathBench().build()
+	bake_project.build()
+	bake_project.bake(
+		Helper.path("build/bin", "res.hxpack"),
+		Helper.rwildcard("./res", lambda path, file: file.endswith((".png", ".jpg")))
+	)
\ No newline at end of file
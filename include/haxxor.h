@@ -4,9 +4,15 @@
 #include <stdbool.h>
 #include <stdint.h>
 
-#define MAXIMUM_VERTICES 5000
-#define MAXIMUM_ELEMENTS MAXIMUM_VERTICES * 4
-#define MAXIMUM_TEXTURE_SLOT 10 // currently not able to be modified
+#define MAXIMUM_VERTICES 65536 // 16384 quads per batch, the most that 16-bit indices can address
+#define MAXIMUM_QUADS (MAXIMUM_VERTICES / 4)
+#define MAXIMUM_ELEMENTS (MAXIMUM_QUADS * 6)
+#define MAXIMUM_TEXTURE_SLOT 32 // upper bound, the actual count comes from GL_MAX_TEXTURE_IMAGE_UNITS
+#define MAXIMUM_TEXTURE_ARRAY_SLOT 4
+#define MAXIMUM_LOADER_THREADS 8
+#define DEFAULT_ASYNC_UPLOAD_BUDGET 2.0 // milliseconds per frame
+#define MAXIMUM_PROFILE_FRAMES 512 // Frames of history kept for GetFrameProfile and the trace
+#define MAXIMUM_PROFILE_EVENTS 16384
 
 typedef struct RECTANGLE {
     float x, y, w, h;
@@ -16,24 +22,188 @@ typedef struct COLOR {
     uint8_t r, g, b, a;
 } COLOR;
 
+typedef struct RENDER_STATS {
+    uint32_t DrawCalls;
+    uint32_t Quads;
+    uint32_t Vertices; // Processed by the GPU, 6 per quad in BATCH_MODE_INSTANCED
+    uint32_t TextureBinds;
+    uint32_t Flushes; // Batches submitted early because vertices or texture slots ran out
+    uint32_t Culled; // Rectangles dropped because they were outside the view
+} RENDER_STATS;
+
+// The target is drawn at the offset on screen, rotated by Rotation radians and scaled by Zoom around it
+typedef struct CAMERA2D {
+    float TargetX, TargetY;
+    float OffsetX, OffsetY;
+    float Rotation;
+    float Zoom;
+} CAMERA2D;
+
+// Scaled and then rotated by Rotation radians around the origin, which is in pixels from the rectangle's corner and stays in place
+typedef struct TRANSFORM2D {
+    float OriginX, OriginY;
+    float Rotation;
+    float ScaleX, ScaleY;
+} TRANSFORM2D;
+
+typedef enum PROFILE_ZONE {
+    PROFILE_FRAME = 0, // From the frame's BeginDraw to the next one, zero until the next frame begins
+    PROFILE_BEGIN_DRAW,
+    PROFILE_END_DRAW,
+    PROFILE_TRANSFER, // Async texture chunks, static layer updates and unmapping non-persistent batch rings, not the batch writes themselves
+    PROFILE_SWAP_BUFFERS,
+    PROFILE_GPU_DRAW, // Resolved a few frames late, zero until then
+    PROFILE_ZONE_COUNT
+} PROFILE_ZONE;
+
+typedef struct FRAME_PROFILE {
+    uint64_t Frame;
+    double Start; // GetTime at BeginDraw
+    double Milliseconds[PROFILE_ZONE_COUNT];
+    RENDER_STATS Stats;
+} FRAME_PROFILE;
+
+typedef enum BATCH_MODE {
+    BATCH_MODE_VERTICES = 0, // Every rectangle is expanded to 4 vertices on the CPU, DrawRectanglePro also rotates them there
+    BATCH_MODE_INSTANCED // Every rectangle is a single instance record, expanded on the GPU, the only mode where rotation costs no extra CPU time
+} BATCH_MODE;
+
+typedef enum BLEND_MODE {
+    BLEND_ALPHA = 0,
+    BLEND_PREMULTIPLIED, // For textures baked with -premultiply
+    BLEND_ADDITIVE
+} BLEND_MODE;
+
 typedef unsigned int TEXTURE2D;
 typedef struct IMAGE IMAGE;
 
+// Quads uploaded once into their own GL_STATIC_DRAW buffer and drawn with a single call, only changed quads are re-uploaded
+typedef struct STATIC_LAYER STATIC_LAYER;
+
+// Uniform grid of RECTANGLEs hashed by cell, so visibility queries only visit the cells around the view
+typedef struct SPATIAL_GRID SPATIAL_GRID;
+
+// Draws recorded on any thread and merged into the frame by EndDraw, one buffer per recording thread
+typedef struct COMMAND_BUFFER COMMAND_BUFFER;
+
+// Decoded on a loader thread and uploaded on the render thread during BeginDraw, valid once IsTextureReady
+typedef struct ASYNC_TEXTURE ASYNC_TEXTURE;
+
+// Texture pack baked offline by tools/bake.c, memory mapped so textures upload without decoding
+typedef struct PACK PACK;
+
+// Many images packed into a few large textures, a new page is added whenever the existing ones are full
+typedef struct ATLAS ATLAS;
+typedef struct ATLAS_REGION {
+    TEXTURE2D Texture; // 0 when the image is larger than a page
+    RECTANGLE Uv; // Normalized sub rectangle of Texture
+} ATLAS_REGION;
+
+// Frames of one texture registered in a table shared with the instance shader, so a sprite only carries its frame index
+typedef struct SPRITE_SHEET SPRITE_SHEET;
+
+// Animation state of many sprites of one sheet, UpdateAnimator advances all of them and only writes their frame indices
+typedef struct ANIMATOR ANIMATOR;
+
+// Same sized images packed into one GL_TEXTURE_2D_ARRAY, any number of its layers draw in a single batch
+typedef struct TEXTURE_ARRAY TEXTURE_ARRAY;
+typedef struct TEXTURE_LAYER {
+    TEXTURE_ARRAY* Array;
+    int Layer; // -1 when the image didn't fit
+} TEXTURE_LAYER;
+
 bool InitHaxxor(const char* name, float width, float height);
 bool ShouldClose();
 void PollEvents();
 void SwapBuffers();
+double GetTime();
 void ShutHaxxor();
+bool IsHeadless();
+int GetFrameWidth();
+int GetFrameHeight();
+bool ReadFramePixels(void* pixels);
+uint64_t GetFrameChecksum();
 
 IMAGE* LoadImage(const void* data, int width, int height);
 IMAGE* LoadImageFromFile(const char* path, bool flip);
 RECTANGLE GetImageShape(const IMAGE* img);
 void DestroyImage(IMAGE* image);
 TEXTURE2D LoadTextureFromImage(const IMAGE* image);
+ASYNC_TEXTURE* LoadTextureAsync(const char* path, bool flip);
+bool IsTextureReady(const ASYNC_TEXTURE* tex);
+bool IsTextureFailed(const ASYNC_TEXTURE* tex);
+TEXTURE2D GetAsyncTexture(const ASYNC_TEXTURE* tex);
+void UnloadAsyncTexture(ASYNC_TEXTURE* tex);
+void SetAsyncUploadBudget(double milliseconds);
+PACK* LoadPack(const char* path);
+int GetPackTextureCount(const PACK* pack);
+const char* GetPackTextureName(const PACK* pack, int index);
+TEXTURE2D LoadTextureFromPack(const PACK* pack, const char* name);
+bool IsPackTexturePremultiplied(const PACK* pack, const char* name);
+void UnloadPack(PACK* pack);
+ATLAS* LoadAtlas(int pageWidth, int pageHeight);
+ATLAS_REGION AddAtlasImage(ATLAS* atlas, const IMAGE* image);
+void DestroyAtlas(ATLAS* atlas);
+TEXTURE_ARRAY* LoadTextureArray(int width, int height, int layers);
+TEXTURE_LAYER LoadTextureLayerFromImage(TEXTURE_ARRAY* array, const IMAGE* image);
+void DestroyTextureArray(TEXTURE_ARRAY* array);
 
 void BeginDraw();
 void EndDraw();
+void BeginCamera(CAMERA2D camera);
+void EndCamera();
+RECTANGLE GetCameraView();
+void SetBatchMode(BATCH_MODE mode);
+void SetBlendMode(BLEND_MODE mode);
 void DrawRectangle(RECTANGLE r, COLOR c);
 void DrawRectangleTex(RECTANGLE r, TEXTURE2D t);
+void DrawRectangleTexUV(RECTANGLE r, TEXTURE2D t, RECTANGLE uv);
+void DrawRectangleLayer(RECTANGLE r, TEXTURE_LAYER t);
+void DrawRectanglePro(RECTANGLE r, TRANSFORM2D transform, COLOR c);
+void DrawRectangleTexPro(RECTANGLE r, TEXTURE2D t, RECTANGLE uv, TRANSFORM2D transform);
+void DrawRectangles(const RECTANGLE* rects, const COLOR* colors, int count);
+void DrawRectanglesTex(const RECTANGLE* rects, int count, TEXTURE2D t);
+RENDER_STATS GetRenderStats();
+
+STATIC_LAYER* LoadStaticLayer(int capacity);
+int AddStaticRectangle(STATIC_LAYER* layer, RECTANGLE r, COLOR c);
+int AddStaticRectangleTex(STATIC_LAYER* layer, RECTANGLE r, TEXTURE2D t, RECTANGLE uv);
+void SetStaticRectangle(STATIC_LAYER* layer, int index, RECTANGLE r, COLOR c);
+bool SetStaticRectangleTex(STATIC_LAYER* layer, int index, RECTANGLE r, TEXTURE2D t, RECTANGLE uv);
+void DrawStaticLayer(STATIC_LAYER* layer);
+void DestroyStaticLayer(STATIC_LAYER* layer);
+
+COMMAND_BUFFER* LoadCommandBuffer();
+void RecordRectangle(COMMAND_BUFFER* buffer, RECTANGLE r, COLOR c, int layer, float depth);
+void RecordRectangleTex(COMMAND_BUFFER* buffer, RECTANGLE r, TEXTURE2D t, RECTANGLE uv, int layer, float depth);
+void SetCommandBlendMode(COMMAND_BUFFER* buffer, BLEND_MODE mode);
+void SetCommandCamera(COMMAND_BUFFER* buffer, const CAMERA2D* camera);
+void SubmitCommandBuffer(COMMAND_BUFFER* buffer);
+void SetCommandSorting(bool enabled);
+void DestroyCommandBuffer(COMMAND_BUFFER* buffer);
+
+SPRITE_SHEET* LoadSpriteSheet(TEXTURE2D t, const RECTANGLE* frames, int count);
+SPRITE_SHEET* LoadSpriteSheetGrid(TEXTURE2D t, int columns, int rows);
+int AddSpriteAnimation(SPRITE_SHEET* sheet, int firstFrame, int framesCount, float framesPerSecond, bool loop);
+void DrawSpriteFrame(RECTANGLE r, const SPRITE_SHEET* sheet, int frame);
+void DestroySpriteSheet(SPRITE_SHEET* sheet);
+ANIMATOR* LoadAnimator(SPRITE_SHEET* sheet, int capacity);
+int AddAnimationInstance(ANIMATOR* animator, int animation);
+void PlayAnimation(ANIMATOR* animator, int instance, int animation);
+void UpdateAnimator(ANIMATOR* animator, float dt);
+int GetAnimationFrame(const ANIMATOR* animator, int instance);
+void DrawAnimator(const ANIMATOR* animator, const RECTANGLE* rects);
+void DestroyAnimator(ANIMATOR* animator);
+
+SPATIAL_GRID* LoadSpatialGrid(float cellSize);
+int AddGridObject(SPATIAL_GRID* grid, RECTANGLE bounds, int userId);
+void MoveGridObject(SPATIAL_GRID* grid, int handle, RECTANGLE bounds);
+void RemoveGridObject(SPATIAL_GRID* grid, int handle);
+int QueryGrid(SPATIAL_GRID* grid, RECTANGLE area, int* results, int maxResults);
+void DestroySpatialGrid(SPATIAL_GRID* grid);
+
+void SetProfiling(bool enabled);
+FRAME_PROFILE GetFrameProfile(int framesAgo);
+bool ExportProfileTrace(const char* path);
 
 #endif
\ No newline at end of file
@@ -11,20 +11,48 @@
 #include <stdbool.h>
 
 #define HXGL_TEX_SLOT_CAPACITY 10
+#ifndef HXGL_RING_SEGMENT_COUNT
+    #define HXGL_RING_SEGMENT_COUNT 3 // triple buffered
+#endif
+
+/**
+ * A buffer split into HXGL_RING_SEGMENT_COUNT segments, one per frame in flight. Every map of a frame is
+ * sub-allocated after the previous one inside the frame's segment, and hxglAdvanceRingBuffer fences the segment
+ * and moves to the next once the frame is done. The CPU only waits when it re-enters a segment the GPU is still
+ * reading, or when a frame outgrows its segment and spills into the next one.
+ * When the driver supports buffer storage the whole buffer stays persistently mapped.
+ */
+typedef struct HXGLRingBuffer {
+    uint32_t Buffer;
+    int Kind;
+    int SegmentSize;
+    int Segment;
+    int Offset; // Start of the current map inside the segment
+    int Used; // Bytes of the segment already written this frame
+    bool Persistent;
+    uint8_t* Mapped;
+    void* Fences[HXGL_RING_SEGMENT_COUNT];
+} HXGLRingBuffer;
 
 bool hxglInit();
 void hxglUseExtension(void* loader);
+bool hxglHasExtension(const char* name);
 void hxglCheckErrors();
 void hxglClear();
 void hxglClearColor(float r, float g, float b, float a);
+void hxglSetBlendFactors(int src, int dst);
 
 uint32_t hxglLoadVertexArray();
 void hxglDropVertexArray(uint32_t vao);
 void hxglEnableVertexArray(uint32_t vao);
 void hxglDisableVertexArray();
 void hxglSetVertexAttribute(unsigned int index, int compCount, int attrKind, bool normalized, int vertexSize, const void *vertexAttrOffset);
+void hxglSetVertexAttributeInteger(unsigned int index, int compCount, int attrKind, int vertexSize, const void *vertexAttrOffset);
+void hxglSetVertexAttributeDivisor(unsigned int index, int divisor);
 void hxglDrawVertexArray(int offset, int count);
+void hxglDrawVertexArrayInstanced(int offset, int count, int instances, int baseInstance);
 void hxglDrawVertexArrayElements(int offset, int count, const void* buffer);
+void hxglDrawVertexArrayElementsBaseVertex(int offset, int count, int indexKind, int baseVertex);
 
 uint32_t hxglLoadVertexBuffer(const void* data, int size, bool dynamic);
 void hxglDropVertexBuffer(uint32_t vbo);
@@ -38,6 +66,13 @@ void hxglUpdateIndexBuffer(uint32_t ibo, const void* data, int dataSize, int off
 void hxglEnableIndexBuffer(uint32_t ibo);
 void hxglDisableIndexBuffer();
 
+bool hxglLoadRingBuffer(HXGLRingBuffer* ring, int bufferKind, int segmentSize);
+void hxglDropRingBuffer(HXGLRingBuffer* ring);
+void* hxglMapRingBuffer(HXGLRingBuffer* ring, int size);
+void hxglUnmapRingBuffer(HXGLRingBuffer* ring, int usedSize);
+void hxglAdvanceRingBuffer(HXGLRingBuffer* ring);
+int hxglGetRingBufferOffset(const HXGLRingBuffer* ring);
+
 uint32_t hxglLoadShader(const char* vertSource, const char* fragSource);
 void hxglDropShader(uint32_t shader);
 void hxglEnableShader(uint32_t shader);
@@ -47,8 +82,33 @@ void hxglSetUniform(int location, const void* value, int uniformKind, int count)
 void hxglSetUniformMat4(int location, const float* value);
 
 uint32_t hxglLoadTexture(const void* data, int width, int height, int filter);
+void hxglUpdateTexture(uint32_t texture, int x, int y, int width, int height, const void* data);
+uint32_t hxglLoadTextureLevels(const void* data, int width, int height, int levels, int filter);
+uint32_t hxglLoadFramebuffer(int width, int height, uint32_t* renderbuffer);
+void hxglDropFramebuffer(uint32_t framebuffer, uint32_t renderbuffer);
+void hxglEnableFramebuffer(uint32_t framebuffer);
+void hxglReadPixels(int x, int y, int width, int height, void* data);
+void hxglLoadQueries(uint32_t* queries, int count);
+void hxglDropQueries(const uint32_t* queries, int count);
+void hxglBeginTimeElapsed(uint32_t query);
+void hxglEndTimeElapsed();
+uint64_t hxglGetQueryResult(uint32_t query);
+uint32_t hxglLoadTextureStorage(int width, int height, int levels, int filter);
+void hxglUpdateTextureFromPixelBuffer(uint32_t texture, int x, int y, int width, int height, uint32_t pbo, int offset);
+void hxglGenerateTextureMipmaps(uint32_t texture);
+void hxglDisablePixelBuffer();
 void hxglEnableTexture(uint32_t texture, int slot);
 void hxglDisableTexture();
+void hxglDropTexture(uint32_t texture);
+uint32_t hxglLoadTextureArray(int width, int height, int layers, int filter);
+void hxglUpdateTextureArrayLayer(uint32_t texture, int layer, const void* data, int width, int height);
+void hxglGenerateTextureArrayMipmaps(uint32_t texture);
+void hxglEnableTextureArray(uint32_t texture, int slot);
+uint32_t hxglLoadTextureBuffer(int size, uint32_t* buffer);
+void hxglUpdateTextureBuffer(uint32_t buffer, const void* data, int dataSize, int offset);
+void hxglEnableTextureBuffer(uint32_t texture, int slot);
+void hxglDropTextureBuffer(uint32_t texture, uint32_t buffer);
+int hxglGetMaxTextureSlots();
 
 
 typedef enum HXGLAttrKind {
@@ -61,6 +121,19 @@ typedef enum HXGLAttrKind {
     HXGL_FLOAT = 0x1406
 } HXGLAttrKind;
 
+typedef enum HXGLBlendFactor {
+    HXGL_BLEND_ZERO = 0,
+    HXGL_BLEND_ONE = 1,
+    HXGL_BLEND_SRC_ALPHA = 0x0302,
+    HXGL_BLEND_ONE_MINUS_SRC_ALPHA = 0x0303
+} HXGLBlendFactor;
+
+typedef enum HXGLBufferKind {
+    HXGL_VERTEX_BUFFER = 0x8892,
+    HXGL_INDEX_BUFFER = 0x8893,
+    HXGL_PIXEL_UNPACK_BUFFER = 0x88EC
+} HXGLBufferKind;
+
 typedef enum HXGLShaderUniformKind {
     HXGL_SHADER_UNIFORM_FLOAT = 0,
     HXGL_SHADER_UNIFORM_VEC2,
@@ -85,6 +158,16 @@ typedef enum HXGLTextureFilter {
 #ifdef HXGL_MAKE_IMPLEMENTATION
     #include <glad/glad.h>
     #include <memory.h>
+    #include <string.h>
+
+    // Buffer storage is core since 4.4, glad is only generated up to 4.3
+    #ifndef GL_MAP_PERSISTENT_BIT
+        #define GL_MAP_PERSISTENT_BIT 0x0040
+    #endif
+    #ifndef GL_MAP_COHERENT_BIT
+        #define GL_MAP_COHERENT_BIT 0x0080
+    #endif
+    typedef void (APIENTRYP PFNHXGLBUFFERSTORAGEPROC)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
 
     #ifndef HXGL_BUILD_RELEASE
         #include <stdio.h>
@@ -145,14 +228,18 @@ typedef enum HXGLTextureFilter {
     typedef struct HXGLContext {
         bool Initialized;
         uint32_t DefaultShader;
+        PFNHXGLBUFFERSTORAGEPROC BufferStorage;
     } HXGLContext;
 
     static HXGLContext HXGL;
+    static GLADloadproc HXGLLoader = NULL;
 
     bool hxglInit()
     {
         if(HXGL.Initialized) return false; // HXGL Already initialized
         memset(&HXGL, 0, sizeof(HXGLContext));
+        if(HXGLLoader && (GLVersion.major > 4 || (GLVersion.major == 4 && GLVersion.minor >= 4) || hxglHasExtension("GL_ARB_buffer_storage")))
+            HXGL.BufferStorage = (PFNHXGLBUFFERSTORAGEPROC)HXGLLoader("glBufferStorage");
         HXGL.DefaultShader = hxglLoadShader(defaultVertSource, defaultFragSource);
         hxglEnableShader(HXGL.DefaultShader);
         glEnable(GL_BLEND);
@@ -170,7 +257,20 @@ typedef enum HXGLTextureFilter {
 
     void hxglUseExtension(void* loader)
     {
-        gladLoadGLLoader((GLADloadproc)loader);
+        HXGLLoader = (GLADloadproc)loader;
+        gladLoadGLLoader(HXGLLoader);
+    }
+
+    bool hxglHasExtension(const char* name)
+    {
+        int count = 0;
+        glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+        for(int i = 0; i < count; i++)
+        {
+            const char* ext = (const char*)glGetStringi(GL_EXTENSIONS, i);
+            if(ext && strcmp(ext, name) == 0) return true;
+        }
+        return false;
     }
 
     void hxglClearColor(float r, float g, float b, float a)
@@ -178,6 +278,11 @@ typedef enum HXGLTextureFilter {
         glClearColor(r, g, b, a);
     }
 
+    void hxglSetBlendFactors(int src, int dst)
+    {
+        glBlendFunc(src, dst);
+    }
+
     void hxglClear()
     {
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -212,16 +317,40 @@ typedef enum HXGLTextureFilter {
         glVertexAttribPointer(index, compCount, type, normalized, stride, pointer);
     }
 
+    void hxglSetVertexAttributeInteger(unsigned int index, int compCount, int type, int stride, const void *pointer)
+    {
+        glEnableVertexAttribArray(index);
+        glVertexAttribIPointer(index, compCount, type, stride, pointer);
+    }
+
+    void hxglSetVertexAttributeDivisor(unsigned int index, int divisor)
+    {
+        glVertexAttribDivisor(index, divisor);
+    }
+
     void hxglDrawVertexArray(int offset, int count)
     {
         glDrawArrays(GL_TRIANGLES, offset, count);
     }
 
+    void hxglDrawVertexArrayInstanced(int offset, int count, int instances, int baseInstance)
+    {
+        glDrawArraysInstancedBaseInstance(GL_TRIANGLES, offset, count, instances, baseInstance);
+    }
+
     void hxglDrawVertexArrayElements(int offset, int count, const void* buffer)
     {
         glDrawElements(GL_TRIANGLES, count, GL_UNSIGNED_INT, (const uint32_t*)buffer + offset);
     }
 
+    void hxglDrawVertexArrayElementsBaseVertex(int offset, int count, int indexKind, int baseVertex)
+    {
+        int indexSize = sizeof(uint32_t);
+        if(indexKind == HXGL_UNSIGNED_SHORT) indexSize = sizeof(uint16_t);
+        else if(indexKind == HXGL_UNSIGNED_BYTE) indexSize = sizeof(uint8_t);
+        glDrawElementsBaseVertex(GL_TRIANGLES, count, indexKind, (const void*)((intptr_t)offset * indexSize), baseVertex);
+    }
+
 
     /** Vertex Buffer */
     uint32_t hxglLoadVertexBuffer(const void* data, int size, bool dynamic)
@@ -286,6 +415,101 @@ typedef enum HXGLTextureFilter {
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
     }
 
+    /** Ring Buffer */
+    bool hxglLoadRingBuffer(HXGLRingBuffer* ring, int bufferKind, int segmentSize)
+    {
+        memset(ring, 0, sizeof(HXGLRingBuffer));
+        ring->Kind = bufferKind;
+        ring->SegmentSize = segmentSize;
+        int size = segmentSize * HXGL_RING_SEGMENT_COUNT;
+
+        glGenBuffers(1, &ring->Buffer);
+        glBindBuffer(bufferKind, ring->Buffer);
+        if(HXGL.BufferStorage)
+        {
+            GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            HXGL.BufferStorage(bufferKind, size, NULL, flags);
+            ring->Mapped = (uint8_t*)glMapBufferRange(bufferKind, 0, size, flags);
+            ring->Persistent = ring->Mapped != NULL;
+        }
+        else
+        {
+            glBufferData(bufferKind, size, NULL, GL_STREAM_DRAW);
+        }
+        if(HXGL.BufferStorage && !ring->Persistent)
+        {
+            LOG_ERROR("%s", "Failed to persistently map ring buffer");
+            glDeleteBuffers(1, &ring->Buffer);
+            return false;
+        }
+        return true;
+    }
+
+    void hxglDropRingBuffer(HXGLRingBuffer* ring)
+    {
+        for(int i = 0; i < HXGL_RING_SEGMENT_COUNT; i++)
+        {
+            if(ring->Fences[i]) glDeleteSync((GLsync)ring->Fences[i]);
+        }
+        if(ring->Persistent)
+        {
+            glBindBuffer(ring->Kind, ring->Buffer);
+            glUnmapBuffer(ring->Kind);
+        }
+        glDeleteBuffers(1, &ring->Buffer);
+        memset(ring, 0, sizeof(HXGLRingBuffer));
+    }
+
+    static void hxglFenceRingSegment(HXGLRingBuffer* ring)
+    {
+        ring->Fences[ring->Segment] = (void*)glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        ring->Segment = (ring->Segment + 1) % HXGL_RING_SEGMENT_COUNT;
+        ring->Used = 0;
+    }
+
+    // size bytes are reserved after whatever the frame already wrote, only usedSize of them are kept by the unmap
+    void* hxglMapRingBuffer(HXGLRingBuffer* ring, int size)
+    {
+        if(ring->Used + size > ring->SegmentSize) hxglFenceRingSegment(ring);
+        GLsync fence = (GLsync)ring->Fences[ring->Segment];
+        if(fence)
+        {
+            // Only blocks when the GPU is still reading this segment from HXGL_RING_SEGMENT_COUNT frames ago
+            GLenum status = glClientWaitSync(fence, 0, 0);
+            while(status == GL_TIMEOUT_EXPIRED)
+                status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+            glDeleteSync(fence);
+            ring->Fences[ring->Segment] = NULL;
+        }
+
+        ring->Offset = ring->Used;
+        int offset = hxglGetRingBufferOffset(ring);
+        if(ring->Persistent) return ring->Mapped + offset;
+        glBindBuffer(ring->Kind, ring->Buffer);
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_FLUSH_EXPLICIT_BIT;
+        return glMapBufferRange(ring->Kind, offset, size, flags);
+    }
+
+    void hxglUnmapRingBuffer(HXGLRingBuffer* ring, int usedSize)
+    {
+        ring->Used = ring->Offset + usedSize;
+        if(ring->Persistent) return; // Coherent mapping, writes are visible to the next draw call
+        glBindBuffer(ring->Kind, ring->Buffer);
+        if(usedSize > 0) glFlushMappedBufferRange(ring->Kind, 0, usedSize);
+        glUnmapBuffer(ring->Kind);
+    }
+
+    // Call once per frame after its last draw from the ring, a frame that wrote nothing keeps its segment
+    void hxglAdvanceRingBuffer(HXGLRingBuffer* ring)
+    {
+        if(ring->Used > 0) hxglFenceRingSegment(ring);
+    }
+
+    int hxglGetRingBufferOffset(const HXGLRingBuffer* ring)
+    {
+        return ring->Segment * ring->SegmentSize + ring->Offset;
+    }
+
     uint32_t hxglLoadShader(const char* vertSource, const char* fragSource)
     {
         // Create and compile the vertex shader
@@ -372,6 +596,134 @@ typedef enum HXGLTextureFilter {
         return tex;
     }
 
+    void hxglUpdateTexture(uint32_t texture, int x, int y, int width, int height, const void* data)
+    {
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, GL_RGBA, GL_UNSIGNED_BYTE, data);
+    }
+
+    // Levels are tightly packed RGBA8, from the full size down to levels - 1
+    uint32_t hxglLoadTextureLevels(const void* data, int width, int height, int levels, int filter)
+    {
+        uint32_t tex = 0;
+        glGenTextures(1, &tex);
+        glBindTexture(GL_TEXTURE_2D, tex);
+        glTexStorage2D(GL_TEXTURE_2D, levels, GL_RGBA8, width, height);
+        const uint8_t* level = (const uint8_t*)data;
+        for(int i = 0; i < levels; i++)
+        {
+            glTexSubImage2D(GL_TEXTURE_2D, i, 0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, level);
+            level += (size_t)width * height * 4;
+            if(width > 1) width /= 2;
+            if(height > 1) height /= 2;
+        }
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter == HXGL_NEAREST ? GL_NEAREST : GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        return tex;
+    }
+
+    // Single RGBA8 color attachment, returns 0 when the driver can't render into it
+    uint32_t hxglLoadFramebuffer(int width, int height, uint32_t* renderbuffer)
+    {
+        uint32_t fbo = 0;
+        glGenRenderbuffers(1, renderbuffer);
+        glBindRenderbuffer(GL_RENDERBUFFER, *renderbuffer);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+        glGenFramebuffers(1, &fbo);
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, *renderbuffer);
+        if(glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        {
+            LOG_ERROR("%s", "Framebuffer is incomplete");
+            hxglDropFramebuffer(fbo, *renderbuffer);
+            return 0;
+        }
+        return fbo;
+    }
+
+    void hxglDropFramebuffer(uint32_t framebuffer, uint32_t renderbuffer)
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glDeleteFramebuffers(1, &framebuffer);
+        glDeleteRenderbuffers(1, &renderbuffer);
+    }
+
+    void hxglEnableFramebuffer(uint32_t framebuffer)
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+    }
+
+    // RGBA8 rows from the bottom up, read from the bound framebuffer
+    void hxglReadPixels(int x, int y, int width, int height, void* data)
+    {
+        glPixelStorei(GL_PACK_ALIGNMENT, 1);
+        glReadPixels(x, y, width, height, GL_RGBA, GL_UNSIGNED_BYTE, data);
+    }
+
+    void hxglLoadQueries(uint32_t* queries, int count)
+    {
+        glGenQueries(count, queries);
+    }
+
+    void hxglDropQueries(const uint32_t* queries, int count)
+    {
+        glDeleteQueries(count, queries);
+    }
+
+    // GL_TIME_ELAPSED queries can't nest, only one is ever open at a time
+    void hxglBeginTimeElapsed(uint32_t query)
+    {
+        glBeginQuery(GL_TIME_ELAPSED, query);
+    }
+
+    void hxglEndTimeElapsed()
+    {
+        glEndQuery(GL_TIME_ELAPSED);
+    }
+
+    // Nanoseconds, blocks until the GPU has finished the queried commands
+    uint64_t hxglGetQueryResult(uint32_t query)
+    {
+        GLuint64 result = 0;
+        glGetQueryObjectui64v(query, GL_QUERY_RESULT, &result);
+        return result;
+    }
+
+    uint32_t hxglLoadTextureStorage(int width, int height, int levels, int filter)
+    {
+        uint32_t tex = 0;
+        glGenTextures(1, &tex);
+        glBindTexture(GL_TEXTURE_2D, tex);
+        glTexStorage2D(GL_TEXTURE_2D, levels, GL_RGBA8, width, height);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter == HXGL_NEAREST ? GL_NEAREST : GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        return tex;
+    }
+
+    // The copy is queued from the pixel buffer, the call returns without waiting for it
+    void hxglUpdateTextureFromPixelBuffer(uint32_t texture, int x, int y, int width, int height, uint32_t pbo, int offset)
+    {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, GL_RGBA, GL_UNSIGNED_BYTE, (const void*)(intptr_t)offset);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+
+    void hxglGenerateTextureMipmaps(uint32_t texture)
+    {
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glGenerateMipmap(GL_TEXTURE_2D);
+    }
+
+    void hxglDisablePixelBuffer()
+    {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+
     void hxglEnableTexture(uint32_t texture, int slot)
     {
         glActiveTexture(GL_TEXTURE0 + slot);
@@ -382,6 +734,94 @@ typedef enum HXGLTextureFilter {
     {
         glBindTexture(GL_TEXTURE_2D, 0);
     }
+
+    void hxglDropTexture(uint32_t texture)
+    {
+        glDeleteTextures(1, &texture);
+    }
+
+    uint32_t hxglLoadTextureArray(int width, int height, int layers, int filter)
+    {
+        int levels = 1;
+        for(int size = width > height ? width : height; size > 1; size >>= 1) levels++;
+
+        GLint previous = 0;
+        glGetIntegerv(GL_TEXTURE_BINDING_2D_ARRAY, &previous);
+        uint32_t tex = 0;
+        glGenTextures(1, &tex);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, tex);
+        glTexStorage3D(GL_TEXTURE_2D_ARRAY, levels, GL_RGBA8, width, height, layers);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, filter);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, filter == HXGL_NEAREST ? GL_NEAREST : GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, previous);
+        return tex;
+    }
+
+    // The array functions put back whatever the active unit had bound, so a resident array slot survives an upload
+    void hxglUpdateTextureArrayLayer(uint32_t texture, int layer, const void* data, int width, int height)
+    {
+        GLint previous = 0;
+        glGetIntegerv(GL_TEXTURE_BINDING_2D_ARRAY, &previous);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, width, height, 1, GL_RGBA, GL_UNSIGNED_BYTE, data);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, previous);
+    }
+
+    // Rebuilds the chain of every layer at once, call it after a run of layer updates rather than after each one
+    void hxglGenerateTextureArrayMipmaps(uint32_t texture)
+    {
+        GLint previous = 0;
+        glGetIntegerv(GL_TEXTURE_BINDING_2D_ARRAY, &previous);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+        glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, previous);
+    }
+
+    void hxglEnableTextureArray(uint32_t texture, int slot)
+    {
+        glActiveTexture(GL_TEXTURE0 + slot);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+    }
+
+    // RGBA32F texels for texelFetch on a samplerBuffer, any shader stage can read them
+    uint32_t hxglLoadTextureBuffer(int size, uint32_t* buffer)
+    {
+        glGenBuffers(1, buffer);
+        glBindBuffer(GL_TEXTURE_BUFFER, *buffer);
+        glBufferData(GL_TEXTURE_BUFFER, size, NULL, GL_STATIC_DRAW);
+        uint32_t tex = 0;
+        glGenTextures(1, &tex);
+        glBindTexture(GL_TEXTURE_BUFFER, tex);
+        glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, *buffer);
+        return tex;
+    }
+
+    void hxglUpdateTextureBuffer(uint32_t buffer, const void* data, int dataSize, int offset)
+    {
+        glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+        glBufferSubData(GL_TEXTURE_BUFFER, offset, dataSize, data);
+    }
+
+    void hxglEnableTextureBuffer(uint32_t texture, int slot)
+    {
+        glActiveTexture(GL_TEXTURE0 + slot);
+        glBindTexture(GL_TEXTURE_BUFFER, texture);
+    }
+
+    void hxglDropTextureBuffer(uint32_t texture, uint32_t buffer)
+    {
+        glDeleteTextures(1, &texture);
+        glDeleteBuffers(1, &buffer);
+    }
+
+    int hxglGetMaxTextureSlots()
+    {
+        int slots = 0;
+        glGetIntegerv(GL_MAX_TEXTURE_IMAGE_UNITS, &slots);
+        return slots;
+    }
 #endif // HXGL_MAKE_IMPLEMENTATION
 
 #endif // __HXGL_H__
\ No newline at end of file
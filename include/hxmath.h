@@ -35,16 +35,53 @@
 #if defined(_MSC_VER)
 	#define INLINE __forceinline
 	#define NO_INLINE __declspec(noinline)
+	#define RESTRICT __restrict
 #elif defined(__clang__)
 	#define INLINE static inline
 	#define NO_INLINE
+	#define RESTRICT __restrict
 #elif defined(__GNUG__) || defined(__GNUC__)
-	#define INLINE inline
+	#define INLINE static inline
 	#define NO_INLINE 
+	#define RESTRICT __restrict
 #else
 	#error "Unsupported Compiler"
 #endif
 
+// VEC4 and MAT4 go through 4-wide registers where the target has them, define HXMATH_NO_SIMD for the scalar code
+#if !defined(HXMATH_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+	#define HXMATH_SSE
+	#include <emmintrin.h>
+	typedef __m128 HXF4;
+	#define Hxf4Load(ptr) _mm_loadu_ps(ptr)
+	#define Hxf4Store(ptr, v) _mm_storeu_ps(ptr, v)
+	#define Hxf4Set1(x) _mm_set1_ps(x)
+	#define Hxf4Add(a, b) _mm_add_ps(a, b)
+	#define Hxf4Sub(a, b) _mm_sub_ps(a, b)
+	#define Hxf4Mul(a, b) _mm_mul_ps(a, b)
+	#define Hxf4Div(a, b) _mm_div_ps(a, b)
+	#define Hxf4MulAdd(a, b, c) _mm_add_ps(a, _mm_mul_ps(b, c))
+	#define Hxf4Lane(v, i) _mm_shuffle_ps(v, v, _MM_SHUFFLE(i, i, i, i))
+	// Lanes x and y come from a, z and w from b, listed in lane order
+	#define Hxf4Shuffle(a, b, x, y, z, w) _mm_shuffle_ps(a, b, _MM_SHUFFLE(w, z, y, x))
+#elif !defined(HXMATH_NO_SIMD) && (defined(__aarch64__) || defined(_M_ARM64))
+	#define HXMATH_NEON
+	#include <arm_neon.h>
+	typedef float32x4_t HXF4;
+	#define Hxf4Load(ptr) vld1q_f32(ptr)
+	#define Hxf4Store(ptr, v) vst1q_f32(ptr, v)
+	#define Hxf4Set1(x) vdupq_n_f32(x)
+	#define Hxf4Add(a, b) vaddq_f32(a, b)
+	#define Hxf4Sub(a, b) vsubq_f32(a, b)
+	#define Hxf4Mul(a, b) vmulq_f32(a, b)
+	#define Hxf4Div(a, b) vdivq_f32(a, b)
+	#define Hxf4MulAdd(a, b, c) vfmaq_f32(a, b, c)
+	#define Hxf4Lane(v, i) vdupq_laneq_f32(v, i)
+#endif
+#if defined(HXMATH_SSE) || defined(HXMATH_NEON)
+	#define HXMATH_SIMD
+#endif
+
 /****************************************************
  ****************************************************
  *
@@ -54,14 +91,141 @@
  ****************************************************/
 
 #include <math.h>
+
+// Polynomial sin and cos, reduced to [-pi/4, pi/4] around the nearest multiple of pi/2
+// Absolute error below 1.2e-7 for |x| < 8192, the reduction loses precision past that
+// Define HXMATH_FAST_MATH to make Sin, Cos and the Normalize functions use the fast versions
+INLINE void FastSinCos(float x, float* s, float* c)
+{
+    const int quadrant = (int)(x * 0.63661977236758134f + copysignf(0.5f, x));
+    const float k = (float)quadrant;
+    // pi / 2 split in three so k * pi / 2 is subtracted without rounding
+    const float r = ((x - k * 1.5703125f) - k * 4.837512969970703125e-4f) - k * 7.54978995489188216e-8f;
+    const float r2 = r * r;
+    const float ps = r + r * r2 * (-1.6666654611e-1f + r2 * (8.3321608736e-3f + r2 * -1.9515295891e-4f));
+    const float pc = 1.0f - 0.5f * r2 + r2 * r2 * (4.166664568298827e-2f + r2 * (-1.388731625493765e-3f + r2 * 2.443315711809948e-5f));
+    // Quadrant select and sign flip on the bits, quadrants are random so branches would mispredict
+    uint32_t sinBits, cosBits;
+    memcpy(&sinBits, &ps, sizeof(sinBits));
+    memcpy(&cosBits, &pc, sizeof(cosBits));
+    const uint32_t swap = (0u - (uint32_t)(quadrant & 1)) & (sinBits ^ cosBits);
+    sinBits ^= swap ^ ((uint32_t)(quadrant & 2) << 30);
+    cosBits ^= swap ^ ((uint32_t)((quadrant + 1) & 2) << 30);
+    memcpy(s, &sinBits, sizeof(sinBits));
+    memcpy(c, &cosBits, sizeof(cosBits));
+}
+
+INLINE float FastSin(float x)
+{
+    float s, c;
+    FastSinCos(x, &s, &c);
+    return s;
+}
+
+INLINE float FastCos(float x)
+{
+    float s, c;
+    FastSinCos(x, &s, &c);
+    return c;
+}
+
+#ifdef HXMATH_SIMD
+// FastSinCos on four lanes with the same operations
+INLINE void Hxf4SinCos(HXF4 x, HXF4* s, HXF4* c)
+{
+#ifdef HXMATH_SSE
+    const __m128 half = _mm_or_ps(_mm_and_ps(x, _mm_set1_ps(-0.0f)), _mm_set1_ps(0.5f));
+    const __m128i quadrant = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(0.63661977236758134f)), half));
+    const HXF4 k = _mm_cvtepi32_ps(quadrant);
+#else
+    const uint32x4_t sign = vandq_u32(vreinterpretq_u32_f32(x), vdupq_n_u32(0x80000000u));
+    const float32x4_t half = vreinterpretq_f32_u32(vorrq_u32(sign, vreinterpretq_u32_f32(vdupq_n_f32(0.5f))));
+    const uint32x4_t quadrant = vreinterpretq_u32_s32(vcvtq_s32_f32(vaddq_f32(vmulq_f32(x, vdupq_n_f32(0.63661977236758134f)), half)));
+    const HXF4 k = vcvtq_f32_s32(vreinterpretq_s32_u32(quadrant));
+#endif
+    const HXF4 r = Hxf4Sub(Hxf4Sub(Hxf4Sub(x, Hxf4Mul(k, Hxf4Set1(1.5703125f))),
+        Hxf4Mul(k, Hxf4Set1(4.837512969970703125e-4f))), Hxf4Mul(k, Hxf4Set1(7.54978995489188216e-8f)));
+    const HXF4 r2 = Hxf4Mul(r, r);
+    HXF4 ps = Hxf4Add(Hxf4Set1(8.3321608736e-3f), Hxf4Mul(r2, Hxf4Set1(-1.9515295891e-4f)));
+    ps = Hxf4Add(Hxf4Set1(-1.6666654611e-1f), Hxf4Mul(r2, ps));
+    ps = Hxf4Add(r, Hxf4Mul(Hxf4Mul(r, r2), ps));
+    HXF4 pc = Hxf4Add(Hxf4Set1(-1.388731625493765e-3f), Hxf4Mul(r2, Hxf4Set1(2.443315711809948e-5f)));
+    pc = Hxf4Add(Hxf4Set1(4.166664568298827e-2f), Hxf4Mul(r2, pc));
+    pc = Hxf4Add(Hxf4Sub(Hxf4Set1(1.0f), Hxf4Mul(Hxf4Set1(0.5f), r2)), Hxf4Mul(Hxf4Mul(r2, r2), pc));
+#ifdef HXMATH_SSE
+    const __m128i one = _mm_set1_epi32(1), two = _mm_set1_epi32(2);
+    const __m128i swap = _mm_and_si128(_mm_sub_epi32(_mm_setzero_si128(), _mm_and_si128(quadrant, one)), _mm_castps_si128(_mm_xor_ps(ps, pc)));
+    const __m128i sinFlip = _mm_slli_epi32(_mm_and_si128(quadrant, two), 30);
+    const __m128i cosFlip = _mm_slli_epi32(_mm_and_si128(_mm_add_epi32(quadrant, one), two), 30);
+    *s = _mm_castsi128_ps(_mm_xor_si128(_mm_castps_si128(ps), _mm_xor_si128(swap, sinFlip)));
+    *c = _mm_castsi128_ps(_mm_xor_si128(_mm_castps_si128(pc), _mm_xor_si128(swap, cosFlip)));
+#else
+    const uint32x4_t one = vdupq_n_u32(1), two = vdupq_n_u32(2);
+    const uint32x4_t odd = vreinterpretq_u32_s32(vnegq_s32(vreinterpretq_s32_u32(vandq_u32(quadrant, one))));
+    const uint32x4_t swap = vandq_u32(odd, veorq_u32(vreinterpretq_u32_f32(ps), vreinterpretq_u32_f32(pc)));
+    const uint32x4_t sinFlip = vshlq_n_u32(vandq_u32(quadrant, two), 30);
+    const uint32x4_t cosFlip = vshlq_n_u32(vandq_u32(vaddq_u32(quadrant, one), two), 30);
+    *s = vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(ps), veorq_u32(swap, sinFlip)));
+    *c = vreinterpretq_f32_u32(veorq_u32(vreinterpretq_u32_f32(pc), veorq_u32(swap, cosFlip)));
+#endif
+}
+#endif
+
+// Same bounds as FastSinCos
+INLINE void SinCosArray(float* RESTRICT s, float* RESTRICT c, const float* RESTRICT x, int count)
+{
+    int i = 0;
+#ifdef HXMATH_SIMD
+    for(; i + 4 <= count; i += 4)
+    {
+        HXF4 sv, cv;
+        Hxf4SinCos(Hxf4Load(x + i), &sv, &cv);
+        Hxf4Store(s + i, sv);
+        Hxf4Store(c + i, cv);
+    }
+#endif
+    for(; i < count; i++) FastSinCos(x[i], &s[i], &c[i]);
+}
+
+// Relative error below 4e-7 with the SSE or NEON estimate, 5e-6 with the scalar fallback
+INLINE float FastRsqrt(float x)
+{
+#if defined(HXMATH_SSE)
+    const float y = _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(x)));
+    return y * (1.5f - 0.5f * x * y * y);
+#elif defined(HXMATH_NEON)
+    float32x2_t v = vdup_n_f32(x);
+    float32x2_t y = vrsqrte_f32(v);
+    y = vmul_f32(y, vrsqrts_f32(vmul_f32(v, y), y));
+    y = vmul_f32(y, vrsqrts_f32(vmul_f32(v, y), y));
+    return vget_lane_f32(y, 0);
+#else
+    uint32_t bits;
+    memcpy(&bits, &x, sizeof(bits));
+    bits = 0x5F375A86u - (bits >> 1);
+    float y;
+    memcpy(&y, &bits, sizeof(y));
+    y = y * (1.5f - 0.5f * x * y * y);
+    return y * (1.5f - 0.5f * x * y * y);
+#endif
+}
+
 INLINE float Sin(float x)
 {
+#ifdef HXMATH_FAST_MATH
+    return FastSin(x);
+#else
     return sin(x);
+#endif
 }
 
 INLINE float Cos(float x)
 {
+#ifdef HXMATH_FAST_MATH
+    return FastCos(x);
+#else
     return cos(x);
+#endif
 }
 
 INLINE float Tan(float x)
@@ -171,10 +335,20 @@ INLINE float Vec2Length(VEC2 vec) {
 	return Sqrt(Vec2LengthSq(vec));
 }
 
+INLINE void Vec2NormalizeFast(VEC2* vec) {
+	const float scale = FastRsqrt(Vec2LengthSq(*vec));
+	vec->x *= scale;
+	vec->y *= scale;
+}
+
 INLINE void Vec2Normalize(VEC2* vec) {
+#ifdef HXMATH_FAST_MATH
+	Vec2NormalizeFast(vec);
+#else
 	const float length = Vec2Length(*vec);
 	vec->x /= length;
 	vec->y /= length;
+#endif
 }
 
 INLINE VEC2 Vec2Normalized(VEC2 vec) {
@@ -321,11 +495,22 @@ INLINE float Vec3Length(VEC3 vec) {
 	return Sqrt(Vec3LengthSq(vec));
 }
 
+INLINE void Vec3NormalizeFast(VEC3* vec) {
+	const float scale = FastRsqrt(Vec3LengthSq(*vec));
+	vec->x *= scale;
+	vec->y *= scale;
+	vec->z *= scale;
+}
+
 INLINE void Vec3Normalize(VEC3* vec) {
+#ifdef HXMATH_FAST_MATH
+	Vec3NormalizeFast(vec);
+#else
 	const float length = Vec3Length(*vec);
 	vec->x /= length;
 	vec->y /= length;
 	vec->z /= length;
+#endif
 }
 
 INLINE VEC3 Vec3Normalized(VEC3 vec) {
@@ -423,50 +608,109 @@ INLINE VEC4 Vec4One() {
 
 INLINE VEC4 Vec4add(VEC4 v0, VEC4 v1) {
 	VEC4 res = Vec4Zero();
+#ifdef HXMATH_SIMD
+	Hxf4Store(res.elements, Hxf4Add(Hxf4Load(v0.elements), Hxf4Load(v1.elements)));
+#else
 	for(int i = 0; i < 4; i++) {
 		res.elements[i] = v0.elements[i] + v1.elements[i];
 	}
+#endif
 	return res;
 }
 
 INLINE VEC4 Vec4Sub(VEC4 v0, VEC4 v1) {
 	VEC4 res = Vec4Zero();
+#ifdef HXMATH_SIMD
+	Hxf4Store(res.elements, Hxf4Sub(Hxf4Load(v0.elements), Hxf4Load(v1.elements)));
+#else
 	for(int i = 0; i < 4; i++) {
 		res.elements[i] = v0.elements[i] - v1.elements[i];
 	}
+#endif
 	return res;
 }
 
 INLINE VEC4 Vec4Mul(VEC4 v0, VEC4 v1) {
 	VEC4 res = Vec4Zero();
+#ifdef HXMATH_SIMD
+	Hxf4Store(res.elements, Hxf4Mul(Hxf4Load(v0.elements), Hxf4Load(v1.elements)));
+#else
 	for(int i = 0; i < 4; i++) {
 		res.elements[i] = v0.elements[i] * v1.elements[i];
 	}
+#endif
 	return res;
 }
 
 INLINE VEC4 Vec4Div(VEC4 v0, VEC4 v1) {
 	VEC4 res = Vec4Zero();
+#ifdef HXMATH_SIMD
+	Hxf4Store(res.elements, Hxf4Div(Hxf4Load(v0.elements), Hxf4Load(v1.elements)));
+#else
 	for(int i = 0; i < 4; i++) {
 		res.elements[i] = v0.elements[i] / v1.elements[i];
 	}
+#endif
 	return res;
 }
 
+#ifdef HXMATH_SIMD
+INLINE float Hxf4Sum(HXF4 v) {
+#ifdef HXMATH_SSE
+	HXF4 pairs = _mm_add_ps(v, _mm_movehl_ps(v, v));
+	return _mm_cvtss_f32(_mm_add_ss(pairs, _mm_shuffle_ps(pairs, pairs, _MM_SHUFFLE(1, 1, 1, 1))));
+#else
+	return vaddvq_f32(v);
+#endif
+}
+#endif
+
+INLINE float Vec4Dot(VEC4 v0, VEC4 v1) {
+#ifdef HXMATH_SIMD
+	return Hxf4Sum(Hxf4Mul(Hxf4Load(v0.elements), Hxf4Load(v1.elements)));
+#else
+	float p = 0;
+	p += v0.x * v1.x;
+	p += v0.y * v1.y;
+	p += v0.z * v1.z;
+	p += v0.w * v1.w;
+	return p;
+#endif
+}
+
 INLINE float Vec4LengthSq(VEC4 vec) {
-	return vec.x * vec.x + vec.y * vec.y + vec.z * vec.z + vec.w * vec.w;
+	return Vec4Dot(vec, vec);
 }
 
 INLINE float Vec4Length(VEC4 vec) {
 	return Sqrt(Vec4LengthSq(vec));
 }
 
+INLINE void Vec4NormalizeFast(VEC4* vec) {
+	const float scale = FastRsqrt(Vec4LengthSq(*vec));
+#ifdef HXMATH_SIMD
+	Hxf4Store(vec->elements, Hxf4Mul(Hxf4Load(vec->elements), Hxf4Set1(scale)));
+#else
+	vec->x *= scale;
+	vec->y *= scale;
+	vec->z *= scale;
+	vec->w *= scale;
+#endif
+}
+
 INLINE void Vec4Normalize(VEC4* vec) {
+#if defined(HXMATH_FAST_MATH)
+	Vec4NormalizeFast(vec);
+#elif defined(HXMATH_SIMD)
+	const float length = Vec4Length(*vec);
+	Hxf4Store(vec->elements, Hxf4Div(Hxf4Load(vec->elements), Hxf4Set1(length)));
+#else
 	const float length = Vec4Length(*vec);
 	vec->x /= length;
 	vec->y /= length;
 	vec->z /= length;
 	vec->w /= length;
+#endif
 }
 
 INLINE VEC4 Vec4Normalized(VEC4 vec) {
@@ -474,15 +718,6 @@ INLINE VEC4 Vec4Normalized(VEC4 vec) {
 	return vec;
 }
 
-INLINE float Vec4Dot(VEC4 v0, VEC4 v1) {
-	float p = 0;
-	p += v0.x * v1.x;
-	p += v0.y * v1.y;
-	p += v0.z * v1.z;
-	p += v0.w * v1.w;
-	return p;
-}
-
 /****************************************************
  ****************************************************
  *
@@ -512,6 +747,21 @@ INLINE MAT4 Mat4Identity() {
 }
 
 INLINE MAT4 Mat4Multiply(MAT4 m0, MAT4 m1) {
+#ifdef HXMATH_SIMD
+	MAT4 res;
+	const HXF4 r0 = Hxf4Load(m1.elements);
+	const HXF4 r1 = Hxf4Load(m1.elements + 4);
+	const HXF4 r2 = Hxf4Load(m1.elements + 8);
+	const HXF4 r3 = Hxf4Load(m1.elements + 12);
+	for(int i = 0; i < 4; ++i) {
+		HXF4 row = Hxf4Load(m0.elements + i * 4);
+		HXF4 dst = Hxf4Mul(Hxf4Lane(row, 0), r0);
+		dst = Hxf4MulAdd(dst, Hxf4Lane(row, 1), r1);
+		dst = Hxf4MulAdd(dst, Hxf4Lane(row, 2), r2);
+		dst = Hxf4MulAdd(dst, Hxf4Lane(row, 3), r3);
+		Hxf4Store(res.elements + i * 4, dst);
+	}
+#else
 	MAT4 res = Mat4Identity();
 	const float* m0_ptr = m0.elements;
 	const float* m1_ptr = m1.elements;
@@ -526,8 +776,9 @@ INLINE MAT4 Mat4Multiply(MAT4 m0, MAT4 m1) {
 				m0_ptr[3] * m1_ptr[12 + j];
 			dst_ptr++;
 		}
-		m1_ptr += 4;
+		m0_ptr += 4;
 	}
+#endif
 	return res;
 }
 
@@ -590,7 +841,69 @@ INLINE MAT4 Mat4LookAt(VEC3 pos, VEC3 target, VEC3 up) {
 	return result;
 }
 
+#ifdef HXMATH_SSE
+// 2x2 blocks stored row major in one register
+INLINE HXF4 Mat2Mul(HXF4 a, HXF4 b) {
+	return _mm_add_ps(_mm_mul_ps(a, Hxf4Shuffle(b, b, 0, 3, 0, 3)), _mm_mul_ps(Hxf4Shuffle(a, a, 1, 0, 3, 2), Hxf4Shuffle(b, b, 2, 1, 2, 1)));
+}
+
+// adjugate(a) * b
+INLINE HXF4 Mat2AdjMul(HXF4 a, HXF4 b) {
+	return _mm_sub_ps(_mm_mul_ps(Hxf4Shuffle(a, a, 3, 3, 0, 0), b), _mm_mul_ps(Hxf4Shuffle(a, a, 1, 1, 2, 2), Hxf4Shuffle(b, b, 2, 3, 0, 1)));
+}
+
+// a * adjugate(b)
+INLINE HXF4 Mat2MulAdj(HXF4 a, HXF4 b) {
+	return _mm_sub_ps(_mm_mul_ps(a, Hxf4Shuffle(b, b, 3, 0, 3, 0)), _mm_mul_ps(Hxf4Shuffle(a, a, 1, 0, 3, 2), Hxf4Shuffle(b, b, 2, 1, 2, 1)));
+}
+#endif
+
 INLINE MAT4 Mat4Inverse(MAT4 matrix) {
+#ifdef HXMATH_SSE
+	// Block inverse, the matrix as | A B | with 2x2 blocks
+	//                              | C D |
+	const HXF4 m0 = Hxf4Load(matrix.elements);
+	const HXF4 m1 = Hxf4Load(matrix.elements + 4);
+	const HXF4 m2 = Hxf4Load(matrix.elements + 8);
+	const HXF4 m3 = Hxf4Load(matrix.elements + 12);
+	HXF4 A = _mm_movelh_ps(m0, m1);
+	HXF4 B = _mm_movehl_ps(m1, m0);
+	HXF4 C = _mm_movelh_ps(m2, m3);
+	HXF4 D = _mm_movehl_ps(m3, m2);
+
+	// |A| |B| |C| |D|
+	HXF4 detSub = _mm_sub_ps(
+		_mm_mul_ps(Hxf4Shuffle(m0, m2, 0, 2, 0, 2), Hxf4Shuffle(m1, m3, 1, 3, 1, 3)),
+		_mm_mul_ps(Hxf4Shuffle(m0, m2, 1, 3, 1, 3), Hxf4Shuffle(m1, m3, 0, 2, 0, 2)));
+	HXF4 detA = Hxf4Lane(detSub, 0);
+	HXF4 detB = Hxf4Lane(detSub, 1);
+	HXF4 detC = Hxf4Lane(detSub, 2);
+	HXF4 detD = Hxf4Lane(detSub, 3);
+
+	HXF4 DC = Mat2AdjMul(D, C);
+	HXF4 AB = Mat2AdjMul(A, B);
+	HXF4 X = _mm_sub_ps(_mm_mul_ps(detD, A), Mat2Mul(B, DC));
+	HXF4 W = _mm_sub_ps(_mm_mul_ps(detA, D), Mat2Mul(C, AB));
+	HXF4 Y = _mm_sub_ps(_mm_mul_ps(detB, C), Mat2MulAdj(D, AB));
+	HXF4 Z = _mm_sub_ps(_mm_mul_ps(detC, B), Mat2MulAdj(A, DC));
+
+	// |M| = |A||D| + |B||C| - trace(adj(A)B adj(D)C)
+	HXF4 trace = _mm_mul_ps(AB, Hxf4Shuffle(DC, DC, 0, 2, 1, 3));
+	HXF4 detM = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(detA, detD), _mm_mul_ps(detB, detC)), Hxf4Set1(Hxf4Sum(trace)));
+	HXF4 rDetM = _mm_div_ps(_mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f), detM);
+	X = _mm_mul_ps(X, rDetM);
+	Y = _mm_mul_ps(Y, rDetM);
+	Z = _mm_mul_ps(Z, rDetM);
+	W = _mm_mul_ps(W, rDetM);
+
+	// The blocks are still adjugates, their swizzle is folded into the store
+	MAT4 result;
+	Hxf4Store(result.elements, Hxf4Shuffle(X, Y, 3, 1, 3, 1));
+	Hxf4Store(result.elements + 4, Hxf4Shuffle(X, Y, 2, 0, 2, 0));
+	Hxf4Store(result.elements + 8, Hxf4Shuffle(Z, W, 3, 1, 3, 1));
+	Hxf4Store(result.elements + 12, Hxf4Shuffle(Z, W, 2, 0, 2, 0));
+	return result;
+#else
 	const float* m = matrix.elements;
 
 	float t0 = m[10] * m[15];
@@ -646,6 +959,7 @@ INLINE MAT4 Mat4Inverse(MAT4 matrix) {
 	o[15] = d * ((t22 * m[10] + t16 * m[2] + t21 * m[6]) - (t20 * m[6] + t23 * m[10] + t17 * m[2]));
 
 	return result;
+#endif
 }
 
 INLINE MAT4 Mat4Translation(VEC3 position) {
@@ -666,6 +980,21 @@ INLINE MAT4 Mat4Scale(VEC3 scale) {
 
 INLINE MAT4 Mat4Transposed(MAT4 matrix) {
     MAT4 out_matrix = Mat4Identity();
+#if defined(HXMATH_SSE)
+    HXF4 r0 = Hxf4Load(matrix.elements);
+    HXF4 r1 = Hxf4Load(matrix.elements + 4);
+    HXF4 r2 = Hxf4Load(matrix.elements + 8);
+    HXF4 r3 = Hxf4Load(matrix.elements + 12);
+    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+    Hxf4Store(out_matrix.elements, r0);
+    Hxf4Store(out_matrix.elements + 4, r1);
+    Hxf4Store(out_matrix.elements + 8, r2);
+    Hxf4Store(out_matrix.elements + 12, r3);
+#elif defined(HXMATH_NEON)
+    // vld4q deinterleaves, so each register is a column
+    float32x4x4_t columns = vld4q_f32(matrix.elements);
+    for(int i = 0; i < 4; i++) Hxf4Store(out_matrix.elements + i * 4, columns.val[i]);
+#else
     out_matrix.elements[0] = matrix.elements[0];
     out_matrix.elements[1] = matrix.elements[4];
     out_matrix.elements[2] = matrix.elements[8];
@@ -682,6 +1011,7 @@ INLINE MAT4 Mat4Transposed(MAT4 matrix) {
     out_matrix.elements[13] = matrix.elements[7];
     out_matrix.elements[14] = matrix.elements[11];
     out_matrix.elements[15] = matrix.elements[15];
+#endif
     return out_matrix;
 }
 
@@ -785,6 +1115,212 @@ INLINE VEC3 Mat4Right(MAT4 matrix) {
     return right;
 }
 
+/****************************************************
+ ****************************************************
+ *
+ *  Batch Transforms
+ *
+ ****************************************************
+ ****************************************************/
+
+// Points are taken as (x, y, 0, 1) rows times the matrix, w is dropped so only affine and orthographic matrices make sense
+// out may be the same array as points
+INLINE void Vec2TransformArray(VEC2* out, const VEC2* points, int count, MAT4 matrix) {
+	const float* m = matrix.elements;
+	int i = 0;
+#ifdef HXMATH_SIMD
+	const HXF4 m0 = Hxf4Set1(m[0]), m1 = Hxf4Set1(m[1]);
+	const HXF4 m4 = Hxf4Set1(m[4]), m5 = Hxf4Set1(m[5]);
+	const HXF4 m12 = Hxf4Set1(m[12]), m13 = Hxf4Set1(m[13]);
+	for(; i + 4 <= count; i += 4) {
+#ifdef HXMATH_SSE
+		HXF4 a = Hxf4Load(points[i].elements);
+		HXF4 b = Hxf4Load(points[i + 2].elements);
+		HXF4 x = Hxf4Shuffle(a, b, 0, 2, 0, 2);
+		HXF4 y = Hxf4Shuffle(a, b, 1, 3, 1, 3);
+#else
+		float32x4x2_t xy = vld2q_f32(points[i].elements);
+		HXF4 x = xy.val[0], y = xy.val[1];
+#endif
+		HXF4 ox = Hxf4MulAdd(Hxf4MulAdd(m12, x, m0), y, m4);
+		HXF4 oy = Hxf4MulAdd(Hxf4MulAdd(m13, x, m1), y, m5);
+#ifdef HXMATH_SSE
+		Hxf4Store(out[i].elements, _mm_unpacklo_ps(ox, oy));
+		Hxf4Store(out[i + 2].elements, _mm_unpackhi_ps(ox, oy));
+#else
+		vst2q_f32(out[i].elements, (float32x4x2_t){ { ox, oy } });
+#endif
+	}
+#endif
+	for(; i < count; i++) {
+		VEC2 p = points[i];
+		out[i].x = m[12] + p.x * m[0] + p.y * m[4];
+		out[i].y = m[13] + p.x * m[1] + p.y * m[5];
+	}
+}
+
+// Points are taken as (x, y, z, 1) rows times the matrix, w is dropped
+INLINE void Vec3TransformArray(VEC3* out, const VEC3* points, int count, MAT4 matrix) {
+	const float* m = matrix.elements;
+	int i = 0;
+#ifdef HXMATH_SIMD
+	const HXF4 m0 = Hxf4Set1(m[0]), m1 = Hxf4Set1(m[1]), m2 = Hxf4Set1(m[2]);
+	const HXF4 m4 = Hxf4Set1(m[4]), m5 = Hxf4Set1(m[5]), m6 = Hxf4Set1(m[6]);
+	const HXF4 m8 = Hxf4Set1(m[8]), m9 = Hxf4Set1(m[9]), m10 = Hxf4Set1(m[10]);
+	const HXF4 m12 = Hxf4Set1(m[12]), m13 = Hxf4Set1(m[13]), m14 = Hxf4Set1(m[14]);
+	for(; i + 4 <= count; i += 4) {
+		const float* src = points[i].elements;
+		float* dst = out[i].elements;
+#ifdef HXMATH_SSE
+		// x0 y0 z0 x1 | y1 z1 x2 y2 | z2 x3 y3 z3
+		HXF4 a = Hxf4Load(src);
+		HXF4 b = Hxf4Load(src + 4);
+		HXF4 c = Hxf4Load(src + 8);
+		HXF4 x = Hxf4Shuffle(a, Hxf4Shuffle(b, c, 2, 2, 1, 1), 0, 3, 0, 2);
+		HXF4 y = Hxf4Shuffle(Hxf4Shuffle(a, b, 1, 1, 0, 0), Hxf4Shuffle(b, c, 3, 3, 2, 2), 0, 2, 0, 2);
+		HXF4 z = Hxf4Shuffle(Hxf4Shuffle(a, b, 2, 2, 1, 1), Hxf4Shuffle(c, c, 0, 0, 3, 3), 0, 2, 0, 2);
+#else
+		float32x4x3_t xyz = vld3q_f32(src);
+		HXF4 x = xyz.val[0], y = xyz.val[1], z = xyz.val[2];
+#endif
+		HXF4 ox = Hxf4MulAdd(Hxf4MulAdd(Hxf4MulAdd(m12, x, m0), y, m4), z, m8);
+		HXF4 oy = Hxf4MulAdd(Hxf4MulAdd(Hxf4MulAdd(m13, x, m1), y, m5), z, m9);
+		HXF4 oz = Hxf4MulAdd(Hxf4MulAdd(Hxf4MulAdd(m14, x, m2), y, m6), z, m10);
+#ifdef HXMATH_SSE
+		Hxf4Store(dst, Hxf4Shuffle(Hxf4Shuffle(ox, oy, 0, 0, 0, 0), Hxf4Shuffle(oz, ox, 0, 0, 1, 1), 0, 2, 0, 2));
+		Hxf4Store(dst + 4, Hxf4Shuffle(Hxf4Shuffle(oy, oz, 1, 1, 1, 1), Hxf4Shuffle(ox, oy, 2, 2, 2, 2), 0, 2, 0, 2));
+		Hxf4Store(dst + 8, Hxf4Shuffle(Hxf4Shuffle(oz, ox, 2, 2, 3, 3), Hxf4Shuffle(oy, oz, 3, 3, 3, 3), 0, 2, 0, 2));
+#else
+		vst3q_f32(dst, (float32x4x3_t){ { ox, oy, oz } });
+#endif
+	}
+#endif
+	for(; i < count; i++) {
+		VEC3 p = points[i];
+		out[i].x = m[12] + p.x * m[0] + p.y * m[4] + p.z * m[8];
+		out[i].y = m[13] + p.x * m[1] + p.y * m[5] + p.z * m[9];
+		out[i].z = m[14] + p.x * m[2] + p.y * m[6] + p.z * m[10];
+	}
+}
+
+/****************************************************
+ ****************************************************
+ *
+ *  Structure of Arrays
+ *
+ ****************************************************
+ ****************************************************/
+
+// Plain loops over separate float arrays so the compiler can vectorize them, 8 lanes with AVX
+// Reductions and compaction keep HXMATH_SOA_LANES partial results so they vectorize as well
+#define HXMATH_SOA_LANES 8
+
+INLINE void SoaIntegrate(float* RESTRICT x, float* RESTRICT y, const float* RESTRICT vx, const float* RESTRICT vy, float dt, int count) {
+	for(int i = 0; i < count; i++) {
+		x[i] += vx[i] * dt;
+		y[i] += vy[i] * dt;
+	}
+}
+
+// Boxes centred on the positions
+INLINE void SoaAabbs(float* RESTRICT minX, float* RESTRICT minY, float* RESTRICT maxX, float* RESTRICT maxY,
+	const float* RESTRICT x, const float* RESTRICT y, const float* RESTRICT halfW, const float* RESTRICT halfH, int count) {
+	for(int i = 0; i < count; i++) {
+		minX[i] = x[i] - halfW[i];
+		minY[i] = y[i] - halfH[i];
+		maxX[i] = x[i] + halfW[i];
+		maxY[i] = y[i] + halfH[i];
+	}
+}
+
+// bounds is minX, minY, maxX, maxY, left inverted when count is 0
+INLINE void SoaPointBounds(float bounds[4], const float* RESTRICT x, const float* RESTRICT y, int count) {
+	float lo[2][HXMATH_SOA_LANES], hi[2][HXMATH_SOA_LANES];
+	for(int j = 0; j < HXMATH_SOA_LANES; j++) {
+		lo[0][j] = lo[1][j] = MATH_INFINITY;
+		hi[0][j] = hi[1][j] = -MATH_INFINITY;
+	}
+	int i = 0;
+	for(; i + HXMATH_SOA_LANES <= count; i += HXMATH_SOA_LANES) {
+		for(int j = 0; j < HXMATH_SOA_LANES; j++) {
+			lo[0][j] = x[i + j] < lo[0][j] ? x[i + j] : lo[0][j];
+			lo[1][j] = y[i + j] < lo[1][j] ? y[i + j] : lo[1][j];
+			hi[0][j] = x[i + j] > hi[0][j] ? x[i + j] : hi[0][j];
+			hi[1][j] = y[i + j] > hi[1][j] ? y[i + j] : hi[1][j];
+		}
+	}
+	for(int j = 0; i < count; i++, j++) {
+		lo[0][j] = x[i] < lo[0][j] ? x[i] : lo[0][j];
+		lo[1][j] = y[i] < lo[1][j] ? y[i] : lo[1][j];
+		hi[0][j] = x[i] > hi[0][j] ? x[i] : hi[0][j];
+		hi[1][j] = y[i] > hi[1][j] ? y[i] : hi[1][j];
+	}
+	bounds[0] = bounds[1] = MATH_INFINITY;
+	bounds[2] = bounds[3] = -MATH_INFINITY;
+	for(int j = 0; j < HXMATH_SOA_LANES; j++) {
+		if(lo[0][j] < bounds[0]) bounds[0] = lo[0][j];
+		if(lo[1][j] < bounds[1]) bounds[1] = lo[1][j];
+		if(hi[0][j] > bounds[2]) bounds[2] = hi[0][j];
+		if(hi[1][j] > bounds[3]) bounds[3] = hi[1][j];
+	}
+}
+
+// Writes the indices of the boxes that overlap the rectangle at x, y with size w, h and returns how many there are
+// indices needs room for count entries
+INLINE int SoaOverlapRect(int* RESTRICT indices, const float* RESTRICT minX, const float* RESTRICT minY, const float* RESTRICT maxX, const float* RESTRICT maxY,
+	float x, float y, float w, float h, int count) {
+	const float right = x + w;
+	const float bottom = y + h;
+	int found = 0;
+	for(int i = 0; i < count; i += HXMATH_SOA_LANES) {
+		const int lanes = count - i < HXMATH_SOA_LANES ? count - i : HXMATH_SOA_LANES;
+		uint8_t hit[HXMATH_SOA_LANES] = { 0 };
+		for(int j = 0; j < lanes; j++) {
+			hit[j] = (minX[i + j] < right) & (maxX[i + j] > x) & (minY[i + j] < bottom) & (maxY[i + j] > y);
+		}
+		for(int j = 0; j < lanes; j++) {
+			indices[found] = i + j;
+			found += hit[j];
+		}
+	}
+	return found;
+}
+
+// 2D affine part of the matrix, the same convention as Vec2TransformArray, outX and outY may be x and y
+INLINE void SoaTransform2D(float* outX, float* outY, const float* x, const float* y, int count, MAT4 matrix) {
+	const float m0 = matrix.elements[0], m1 = matrix.elements[1];
+	const float m4 = matrix.elements[4], m5 = matrix.elements[5];
+	const float m12 = matrix.elements[12], m13 = matrix.elements[13];
+	for(int i = 0; i < count; i++) {
+		const float px = x[i];
+		const float py = y[i];
+		outX[i] = m12 + px * m0 + py * m4;
+		outY[i] = m13 + px * m1 + py * m5;
+	}
+}
+
+// Interleaves into x, y, w, h quadruples, the layout of haxxor's RECTANGLE, ready for DrawRectangles
+// indices picks which entries to take, NULL takes the first count
+INLINE void SoaToRects(float* RESTRICT rects, const float* RESTRICT x, const float* RESTRICT y, const float* RESTRICT w, const float* RESTRICT h,
+	const int* RESTRICT indices, int count) {
+	if(indices) {
+		for(int i = 0; i < count; i++) {
+			const int k = indices[i];
+			rects[i * 4 + 0] = x[k];
+			rects[i * 4 + 1] = y[k];
+			rects[i * 4 + 2] = w[k];
+			rects[i * 4 + 3] = h[k];
+		}
+		return;
+	}
+	for(int i = 0; i < count; i++) {
+		rects[i * 4 + 0] = x[i];
+		rects[i * 4 + 1] = y[i];
+		rects[i * 4 + 2] = w[i];
+		rects[i * 4 + 3] = h[i];
+	}
+}
+
 /****************************************************
  ****************************************************
  *
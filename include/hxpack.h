@@ -0,0 +1,39 @@
+/***
+ * "hxpack.h" describes the baked texture pack written by tools/bake.c and read by LoadPack.
+ * Every texture is stored as a ready to upload RGBA8 mip chain so loading never has to decode anything.
+ *
+ * Layout: HXPackHeader, HXPackEntry[EntriesCount], then the level data of every entry.
+ * Levels are tightly packed from the largest to the smallest and every entry starts on HXPACK_ALIGNMENT.
+ */
+
+#ifndef __HXPACK_H__
+#define __HXPACK_H__
+
+#include <stdint.h>
+
+#define HXPACK_MAGIC 0x4B505848 // "HXPK" in little endian
+#define HXPACK_VERSION 1
+#define HXPACK_NAME_LENGTH 64
+#define HXPACK_ALIGNMENT 16
+
+typedef enum HXPackFlags {
+    HXPACK_PREMULTIPLIED = 1 << 0
+} HXPackFlags;
+
+typedef struct HXPackHeader {
+    uint32_t Magic;
+    uint32_t Version;
+    uint32_t EntriesCount;
+    uint32_t Reserved;
+} HXPackHeader;
+
+typedef struct HXPackEntry {
+    char Name[HXPACK_NAME_LENGTH];
+    uint32_t Width, Height;
+    uint32_t Levels;
+    uint32_t Flags;
+    uint64_t Offset; // From the start of the file
+    uint64_t Size; // Of the whole mip chain
+} HXPackEntry;
+
+#endif // __HXPACK_H__
@@ -1,10 +1,60 @@
 #define HXGL_MAKE_IMPLEMENTATION
 #include "hxgl.h"
 #include "haxxor.h"
+#ifdef HAXXOR_NO_SIMD
+    #define HXMATH_NO_SIMD
+#endif
 #include "hxmath.h"
+#include "hxpack.h"
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 #include <GLFW/glfw3.h>
+#include <stdio.h>
+#ifdef _WIN32
+    #define WIN32_LEAN_AND_MEAN
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <pthread.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+/** Threading */
+#ifdef _WIN32
+    typedef HANDLE Thread;
+    typedef CRITICAL_SECTION Mutex;
+    typedef CONDITION_VARIABLE Condition;
+    #define THREAD_RESULT DWORD WINAPI
+    static void ThreadStart(Thread* thread, LPTHREAD_START_ROUTINE fn, void* arg) { *thread = CreateThread(NULL, 0, fn, arg, 0, NULL); }
+    static void ThreadJoin(Thread thread) { WaitForSingleObject(thread, INFINITE); CloseHandle(thread); }
+    static void MutexInit(Mutex* mutex) { InitializeCriticalSection(mutex); }
+    static void MutexDestroy(Mutex* mutex) { DeleteCriticalSection(mutex); }
+    static void MutexLock(Mutex* mutex) { EnterCriticalSection(mutex); }
+    static void MutexUnlock(Mutex* mutex) { LeaveCriticalSection(mutex); }
+    static void ConditionInit(Condition* cond) { InitializeConditionVariable(cond); }
+    static void ConditionDestroy(Condition* cond) { (void)cond; }
+    static void ConditionWait(Condition* cond, Mutex* mutex) { SleepConditionVariableCS(cond, mutex, INFINITE); }
+    static void ConditionBroadcast(Condition* cond) { WakeAllConditionVariable(cond); }
+    static int GetProcessorCount() { SYSTEM_INFO info; GetSystemInfo(&info); return (int)info.dwNumberOfProcessors; }
+#else
+    typedef pthread_t Thread;
+    typedef pthread_mutex_t Mutex;
+    typedef pthread_cond_t Condition;
+    #define THREAD_RESULT void*
+    static void ThreadStart(Thread* thread, void* (*fn)(void*), void* arg) { pthread_create(thread, NULL, fn, arg); }
+    static void ThreadJoin(Thread thread) { pthread_join(thread, NULL); }
+    static void MutexInit(Mutex* mutex) { pthread_mutex_init(mutex, NULL); }
+    static void MutexDestroy(Mutex* mutex) { pthread_mutex_destroy(mutex); }
+    static void MutexLock(Mutex* mutex) { pthread_mutex_lock(mutex); }
+    static void MutexUnlock(Mutex* mutex) { pthread_mutex_unlock(mutex); }
+    static void ConditionInit(Condition* cond) { pthread_cond_init(cond, NULL); }
+    static void ConditionDestroy(Condition* cond) { pthread_cond_destroy(cond); }
+    static void ConditionWait(Condition* cond, Mutex* mutex) { pthread_cond_wait(cond, mutex); }
+    static void ConditionBroadcast(Condition* cond) { pthread_cond_broadcast(cond); }
+    static int GetProcessorCount() { return (int)sysconf(_SC_NPROCESSORS_ONLN); }
+#endif
 
 /** Utilities */
 VEC4 ColorToVec4(COLOR col)
@@ -12,12 +62,255 @@ VEC4 ColorToVec4(COLOR col)
     return Vec4Create(col.r / 255.0f, col.g / 255.0f, col.b / 255.0f, col.a / 255.0f);
 }
 
+static uint16_t ToUnorm16(float x)
+{
+    if(x <= 0.0f) return 0;
+    if(x >= 1.0f) return UINT16_MAX;
+    return (uint16_t)(x * UINT16_MAX + 0.5f);
+}
+
+static const RECTANGLE FULL_UV = { 0.0f, 0.0f, 1.0f, 1.0f };
+static const COLOR WHITE = { 255, 255, 255, 255 };
+
+// Full batches a frame can stream through its ring segment, a frame past that spills into the next frame's segment
+// and may wait on the GPU. Every batch mode keeps HXGL_RING_SEGMENT_COUNT segments of this size, 8 fits 100k quads
+#ifndef HAXXOR_FRAME_BATCHES
+    #define HAXXOR_FRAME_BATCHES 8
+#endif
+
+// Define HAXXOR_COMPACT_VERTEX when building haxxor to halve the per-vertex upload (20 bytes instead of 40)
+#ifdef HAXXOR_COMPACT_VERTEX
+typedef struct Vertex {
+    VEC2 Pos;
+    COLOR Color; // RGBA8, normalized by the attribute
+    uint16_t TexCoords[2]; // Normalized by the attribute
+    int32_t TexID;
+} Vertex;
+#else
 typedef struct Vertex {
     VEC3 Pos;
     VEC4 Color;
     VEC2 TexCoords;
     float TexID;
 } Vertex;
+#endif
+
+// One record per rectangle in BATCH_MODE_INSTANCED, expanded against a static unit quad on the GPU
+typedef struct Instance {
+    RECTANGLE Rect;
+    COLOR Color; // RGBA8, normalized by the attribute
+    uint16_t TexRect[4]; // u0, v0, u1, v1 normalized by the attribute
+    int32_t TexID;
+    float Pivot[2]; // Rotation centre from the rectangle's corner, the shader rotates around it
+    float Rotation;
+    int32_t Frame; // 1 + row of the frame table the shader takes the UVs from, 0 uses TexRect
+} Instance;
+
+// Quad indices never change so they're generated once, 16-bit whenever the vertex count allows it
+#if MAXIMUM_VERTICES <= 65536
+typedef uint16_t Element;
+#define ELEMENT_KIND HXGL_UNSIGNED_SHORT
+#else
+typedef uint32_t Element;
+#define ELEMENT_KIND HXGL_UNSIGNED_INT
+#endif
+
+/** Quad Kernels */
+// Expand count rectangles into 4 vertices each, colors advance by colorStride so a single color can be repeated
+typedef void (*QuadKernel)(Vertex* v, const RECTANGLE* rects, const COLOR* colors, int colorStride, int texId, int count);
+
+// Define HAXXOR_NO_SIMD to fall back to the portable kernel on x86-64 as well
+#if (defined(__x86_64__) || defined(_M_X64)) && !defined(HAXXOR_NO_SIMD)
+#define HAXXOR_X86
+#endif
+
+#ifndef HAXXOR_X86
+static void ExpandQuadsScalar(Vertex* v, const RECTANGLE* rects, const COLOR* colors, int colorStride, int texId, int count)
+{
+    for(int i = 0; i < count; i++, v += 4, colors += colorStride)
+    {
+        RECTANGLE r = rects[i];
+#ifdef HAXXOR_COMPACT_VERTEX
+        COLOR c = *colors;
+        v[0] = (Vertex){ Vec2Create(r.x, r.y), c, { 0, 0 }, texId };
+        v[1] = (Vertex){ Vec2Create(r.x + r.w, r.y), c, { UINT16_MAX, 0 }, texId };
+        v[2] = (Vertex){ Vec2Create(r.x + r.w, r.y + r.h), c, { UINT16_MAX, UINT16_MAX }, texId };
+        v[3] = (Vertex){ Vec2Create(r.x, r.y + r.h), c, { 0, UINT16_MAX }, texId };
+#else
+        VEC4 color = ColorToVec4(*colors);
+        v[0] = (Vertex){ Vec3Create(r.x, r.y, 0.0f), color, Vec2Create(0.0f, 0.0f), (float)texId };
+        v[1] = (Vertex){ Vec3Create(r.x + r.w, r.y, 0.0f), color, Vec2Create(1.0f, 0.0f), (float)texId };
+        v[2] = (Vertex){ Vec3Create(r.x + r.w, r.y + r.h, 0.0f), color, Vec2Create(1.0f, 1.0f), (float)texId };
+        v[3] = (Vertex){ Vec3Create(r.x, r.y + r.h, 0.0f), color, Vec2Create(0.0f, 1.0f), (float)texId };
+#endif
+    }
+}
+#else
+#include <immintrin.h>
+#ifdef _MSC_VER
+    #include <intrin.h>
+    #define TARGET_AVX2
+#else
+    #define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+// The kernels store whole vertices as runs of 32-bit lanes
+#ifdef HAXXOR_COMPACT_VERTEX
+_Static_assert(sizeof(Vertex) == 20 && offsetof(Vertex, TexID) == 16, "Unexpected compact vertex layout");
+#else
+_Static_assert(sizeof(Vertex) == 40 && offsetof(Vertex, Color) == 12 && offsetof(Vertex, TexCoords) == 28, "Unexpected vertex layout");
+#endif
+
+static int32_t LoadColorBits(const COLOR* c)
+{
+    int32_t bits;
+    memcpy(&bits, c, sizeof(bits));
+    return bits;
+}
+
+// SSE2 is part of x86-64, so this is the fallback on every 64-bit x86 CPU
+static void ExpandQuadsSSE2(Vertex* v, const RECTANGLE* rects, const COLOR* colors, int colorStride, int texId, int count)
+{
+#ifdef HAXXOR_COMPACT_VERTEX
+    // u and v packed into one lane, u in the low half
+    const __m128 uv00 = _mm_castsi128_ps(_mm_cvtsi32_si128(0x00000000));
+    const __m128 uv10 = _mm_castsi128_ps(_mm_cvtsi32_si128(0x0000FFFF));
+    const __m128 uv11 = _mm_castsi128_ps(_mm_cvtsi32_si128((int)0xFFFFFFFF));
+    const __m128 uv01 = _mm_castsi128_ps(_mm_cvtsi32_si128((int)0xFFFF0000));
+    for(int i = 0; i < count; i++, v += 4, colors += colorStride)
+    {
+        __m128 r = _mm_loadu_ps(&rects[i].x);
+        __m128 p = _mm_movelh_ps(r, _mm_add_ps(r, _mm_movehl_ps(r, r))); // x0, y0, x1, y1
+        __m128 c = _mm_castsi128_ps(_mm_cvtsi32_si128(LoadColorBits(colors)));
+        _mm_storeu_ps((float*)&v[0], _mm_shuffle_ps(p, _mm_unpacklo_ps(c, uv00), _MM_SHUFFLE(1, 0, 1, 0)));
+        v[0].TexID = texId;
+        _mm_storeu_ps((float*)&v[1], _mm_shuffle_ps(p, _mm_unpacklo_ps(c, uv10), _MM_SHUFFLE(1, 0, 1, 2)));
+        v[1].TexID = texId;
+        _mm_storeu_ps((float*)&v[2], _mm_shuffle_ps(p, _mm_unpacklo_ps(c, uv11), _MM_SHUFFLE(1, 0, 3, 2)));
+        v[2].TexID = texId;
+        _mm_storeu_ps((float*)&v[3], _mm_shuffle_ps(p, _mm_unpacklo_ps(c, uv01), _MM_SHUFFLE(1, 0, 3, 0)));
+        v[3].TexID = texId;
+    }
+#else
+    // Every vertex is stored as pos + r, g + b + a + u, v + texId
+    const __m128 scale = _mm_set1_ps(255.0f);
+    const __m128 alphaU = _mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f);
+    const __m128 vTex0 = _mm_setr_ps(0.0f, (float)texId, 0.0f, 0.0f);
+    const __m128 vTex1 = _mm_setr_ps(1.0f, (float)texId, 0.0f, 0.0f);
+    const __m128i zero = _mm_setzero_si128();
+    for(int i = 0; i < count; i++, v += 4, colors += colorStride)
+    {
+        __m128 r = _mm_loadu_ps(&rects[i].x);
+        __m128 p = _mm_movelh_ps(r, _mm_add_ps(r, _mm_movehl_ps(r, r))); // x0, y0, x1, y1
+        __m128i ci = _mm_cvtsi32_si128(LoadColorBits(colors));
+        ci = _mm_unpacklo_epi16(_mm_unpacklo_epi8(ci, zero), zero);
+        __m128 col = _mm_div_ps(_mm_cvtepi32_ps(ci), scale);
+        __m128 zr = _mm_unpacklo_ps(_mm_setzero_ps(), col); // 0, r, 0, g
+        __m128 ba = _mm_unpackhi_ps(col, alphaU); // b, 0, a, 1
+        __m128 gbaU0 = _mm_shuffle_ps(col, ba, _MM_SHUFFLE(1, 2, 2, 1));
+        __m128 gbaU1 = _mm_shuffle_ps(col, ba, _MM_SHUFFLE(3, 2, 2, 1));
+
+        float* f = (float*)v;
+        _mm_storeu_ps(f + 0, _mm_shuffle_ps(p, zr, _MM_SHUFFLE(1, 0, 1, 0)));
+        _mm_storeu_ps(f + 4, gbaU0);
+        _mm_storel_pi((__m64*)(f + 8), vTex0);
+        _mm_storeu_ps(f + 10, _mm_shuffle_ps(p, zr, _MM_SHUFFLE(1, 0, 1, 2)));
+        _mm_storeu_ps(f + 14, gbaU1);
+        _mm_storel_pi((__m64*)(f + 18), vTex0);
+        _mm_storeu_ps(f + 20, _mm_shuffle_ps(p, zr, _MM_SHUFFLE(1, 0, 3, 2)));
+        _mm_storeu_ps(f + 24, gbaU1);
+        _mm_storel_pi((__m64*)(f + 28), vTex1);
+        _mm_storeu_ps(f + 30, _mm_shuffle_ps(p, zr, _MM_SHUFFLE(1, 0, 3, 0)));
+        _mm_storeu_ps(f + 34, gbaU0);
+        _mm_storel_pi((__m64*)(f + 38), vTex1);
+    }
+#endif
+}
+
+// One quad per iteration, every 32-byte store is a permute of the quad's positions and color blended with constant lanes
+TARGET_AVX2 static void ExpandQuadsAVX2(Vertex* v, const RECTANGLE* rects, const COLOR* colors, int colorStride, int texId, int count)
+{
+#ifdef HAXXOR_COMPACT_VERTEX
+    // The integer texId and uv lanes are moved around as float bit patterns
+    float t, uv10, uv11, uv01;
+    memcpy(&t, &texId, sizeof(float));
+    // Source lanes are x0, y0, x1, y1, color, the uv and texId lanes come from the constants
+    memcpy(&uv10, &(uint32_t){ 0x0000FFFF }, sizeof(float));
+    memcpy(&uv11, &(uint32_t){ 0xFFFFFFFF }, sizeof(float));
+    memcpy(&uv01, &(uint32_t){ 0xFFFF0000 }, sizeof(float));
+    const __m256i idx0 = _mm256_setr_epi32(0, 1, 4, 0, 0, 2, 1, 4);
+    const __m256i idx1 = _mm256_setr_epi32(0, 0, 2, 3, 4, 0, 0, 0);
+    const __m256i idx2 = _mm256_setr_epi32(3, 4, 0, 0, 0, 0, 0, 0);
+    const __m256 k0 = _mm256_setr_ps(0.0f, 0.0f, 0.0f, 0.0f, t, 0.0f, 0.0f, 0.0f);
+    const __m256 k1 = _mm256_setr_ps(uv10, t, 0.0f, 0.0f, 0.0f, uv11, t, 0.0f);
+    const __m256 k2 = _mm256_setr_ps(0.0f, 0.0f, uv01, t, 0.0f, 0.0f, 0.0f, 0.0f);
+    for(int i = 0; i < count; i++, v += 4, colors += colorStride)
+    {
+        __m128 r = _mm_loadu_ps(&rects[i].x);
+        __m128 p = _mm_movelh_ps(r, _mm_add_ps(r, _mm_movehl_ps(r, r)));
+        __m256 src = _mm256_insertf128_ps(_mm256_castps128_ps256(p), _mm_castsi128_ps(_mm_cvtsi32_si128(LoadColorBits(colors))), 1);
+        float* f = (float*)v;
+        _mm256_storeu_ps(f + 0, _mm256_blend_ps(_mm256_permutevar8x32_ps(src, idx0), k0, 0x18));
+        _mm256_storeu_ps(f + 8, _mm256_blend_ps(_mm256_permutevar8x32_ps(src, idx1), k1, 0x63));
+        _mm_storeu_ps(f + 16, _mm256_castps256_ps128(_mm256_blend_ps(_mm256_permutevar8x32_ps(src, idx2), k2, 0x0C)));
+    }
+#else
+    // Source lanes are x0, y0, x1, y1, r, g, b, a, the z, uv and texId lanes come from the constants
+    float t = (float)texId;
+    const __m128 scale = _mm_set1_ps(255.0f);
+    const __m256i idx0 = _mm256_setr_epi32(0, 1, 0, 4, 5, 6, 7, 0);
+    const __m256i idx1 = _mm256_setr_epi32(0, 0, 2, 1, 0, 4, 5, 6);
+    const __m256i idx2 = _mm256_setr_epi32(7, 0, 0, 0, 2, 3, 0, 4);
+    const __m256i idx3 = _mm256_setr_epi32(5, 6, 7, 0, 0, 0, 0, 3);
+    const __m256i idx4 = _mm256_setr_epi32(0, 4, 5, 6, 7, 0, 0, 0);
+    const __m256 k0 = _mm256_setzero_ps();
+    const __m256 k1 = _mm256_setr_ps(0.0f, t, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+    const __m256 k2 = _mm256_setr_ps(0.0f, 1.0f, 0.0f, t, 0.0f, 0.0f, 0.0f, 0.0f);
+    const __m256 k3 = _mm256_setr_ps(0.0f, 0.0f, 0.0f, 1.0f, 1.0f, t, 0.0f, 0.0f);
+    const __m256 k4 = _mm256_setr_ps(0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, t);
+    for(int i = 0; i < count; i++, v += 4, colors += colorStride)
+    {
+        __m128 r = _mm_loadu_ps(&rects[i].x);
+        __m128 p = _mm_movelh_ps(r, _mm_add_ps(r, _mm_movehl_ps(r, r)));
+        __m128 col = _mm_div_ps(_mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(LoadColorBits(colors)))), scale);
+        __m256 src = _mm256_insertf128_ps(_mm256_castps128_ps256(p), col, 1);
+        float* f = (float*)v;
+        _mm256_storeu_ps(f + 0, _mm256_blend_ps(_mm256_permutevar8x32_ps(src, idx0), k0, 0x84));
+        _mm256_storeu_ps(f + 8, _mm256_blend_ps(_mm256_permutevar8x32_ps(src, idx1), k1, 0x13));
+        _mm256_storeu_ps(f + 16, _mm256_blend_ps(_mm256_permutevar8x32_ps(src, idx2), k2, 0x4E));
+        _mm256_storeu_ps(f + 24, _mm256_blend_ps(_mm256_permutevar8x32_ps(src, idx3), k3, 0x38));
+        _mm256_storeu_ps(f + 32, _mm256_blend_ps(_mm256_permutevar8x32_ps(src, idx4), k4, 0xE1));
+    }
+#endif
+}
+
+static bool CpuHasAvx2()
+{
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    __cpuidex(info, 7, 0);
+    bool avx2 = (info[1] & (1 << 5)) != 0;
+    // The OS has to save the ymm registers too
+    return osxsave && avx && avx2 && (_xgetbv(0) & 6) == 6;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+static QuadKernel SelectQuadKernel()
+{
+#ifdef HAXXOR_X86
+    if(CpuHasAvx2()) return ExpandQuadsAVX2;
+    return ExpandQuadsSSE2;
+#else
+    return ExpandQuadsScalar;
+#endif
+}
 
 struct IMAGE {
     bool LoadedFromFile;
@@ -25,7 +318,192 @@ struct IMAGE {
     int Width, Height;
 };
 
+// Skyline bin packer, every page is a texture and the nodes are the top edge of what's been packed so far
+typedef struct AtlasNode {
+    int X, Y, Width;
+} AtlasNode;
+
+typedef struct AtlasPage {
+    TEXTURE2D Texture;
+    AtlasNode* Nodes;
+    int NodesCount;
+} AtlasPage;
+
+struct ATLAS {
+    int Width, Height;
+    AtlasPage* Pages;
+    int PagesCount;
+};
+
+struct PACK {
+    const uint8_t* Data; // The whole file, mapped read only
+    size_t Size;
+    const HXPackHeader* Header;
+    const HXPackEntry* Entries;
+#ifdef _WIN32
+    HANDLE File, Mapping;
+#endif
+};
+
+typedef enum AsyncState {
+    ASYNC_LOADING = 0,
+    ASYNC_READY,
+    ASYNC_FAILED
+} AsyncState;
+
+// Decoded by a loader thread, then uploaded by the render thread a few rows at a time
+struct ASYNC_TEXTURE {
+    char* Path;
+    bool Flip;
+    uint8_t* Pixels; // Written by the worker before it's queued back to the render thread
+    int Width, Height;
+    // Everything below is only touched by the render thread
+    AsyncState State;
+    bool Released;
+    TEXTURE2D Texture;
+    int UploadedRows;
+    ASYNC_TEXTURE* Next;
+};
+
+typedef struct Bounds {
+    float MinX, MinY, MaxX, MaxY;
+} Bounds;
+
+struct STATIC_LAYER {
+    uint32_t VAO, VBO;
+    Vertex* Vertices; // CPU copy, dirty quads are uploaded from here
+    int QuadsCount, Capacity;
+    TEXTURE2D Textures[MAXIMUM_TEXTURE_SLOT]; // Bound to the first slots while the layer draws
+    int TexturesCount;
+    int DirtyFirst, DirtyLast; // Quads changed since the last upload, empty when DirtyFirst > DirtyLast
+};
+
+typedef struct GridObject {
+    RECTANGLE Bounds;
+    int UserId;
+    int MinX, MinY, MaxX, MaxY; // Cells covered, MinX > MaxX while the object sits in the oversized list
+    uint32_t Stamp; // Query that last returned the object, so objects in several cells are reported once
+    bool Alive;
+} GridObject;
+
+typedef struct GridCell {
+    int32_t X, Y;
+    bool Used;
+    int* Objects;
+    int Count, Capacity;
+} GridCell;
+
+#define GRID_MAXIMUM_SPAN 64 // Objects covering more cells than this are kept in a list every query checks
+#define GRID_MAXIMUM_COORD (1 << 30) // Cell coordinates are clamped to this, spans between them still fit in 64 bits
+
+struct SPATIAL_GRID {
+    float CellSize, InvCellSize;
+    GridObject* Objects;
+    int ObjectsCount, ObjectsCapacity;
+    int* FreeObjects; // Handles of removed objects, reused first
+    int FreeCount, FreeCapacity;
+    GridCell* Cells; // Open addressing on the cell coordinates, power of two sized
+    int CellsCapacity, CellsUsed;
+    GridCell Oversized;
+    uint32_t Stamp;
+};
+
+typedef struct DrawCommand {
+    RECTANGLE Rect;
+    RECTANGLE Uv;
+    COLOR Color;
+    TEXTURE2D Texture; // 0 for solid rectangles
+    int16_t Layer;
+    uint8_t Blend;
+    float Depth;
+} DrawCommand;
+
+// Filled by one recording thread, read by the render thread once submitted
+struct COMMAND_BUFFER {
+    int Id; // Submitted buffers are merged in Id order so the result doesn't depend on thread timing
+    DrawCommand* Commands;
+    Vertex* Vertices; // Expanded while recording, 4 per command with the texture slot patched in at merge time
+    int Count, Capacity;
+    BLEND_MODE Blend; // Applies to everything recorded after SetCommandBlendMode
+    bool HasCamera;
+    CAMERA2D Camera; // The whole buffer is drawn through it when HasCamera, in screen space otherwise
+    int CameraSlot; // Set by the merge, buffers with the same camera share a slot
+    bool Submitted; // Queued for the next EndDraw, guarded by the submit lock
+    COMMAND_BUFFER* NextSubmitted;
+};
+
+typedef struct CommandRef {
+    uint64_t Key;
+    int Buffer, Index;
+} CommandRef;
+
+typedef struct ProfileEvent {
+    PROFILE_ZONE Zone;
+    double Start, Duration; // Seconds
+} ProfileEvent;
+
+#define PROFILE_GPU_LATENCY 4 // Frames before GPU timer queries are read back
+#define PROFILE_GPU_TIMERS 256 // Draw calls timed per frame, later ones go untimed
+
+typedef struct AsyncQueue {
+    ASYNC_TEXTURE *Head, *Tail;
+} AsyncQueue;
+
+// Rows of the frame table given back by destroyed sprite sheets
+typedef struct FrameRange {
+    int First, Count;
+} FrameRange;
+
+typedef struct SpriteAnimation {
+    int FirstFrame, FramesCount; // Frames of the sheet
+    float FramesPerSecond;
+    bool Loop; // Otherwise holds the last frame
+} SpriteAnimation;
+
+struct SPRITE_SHEET {
+    TEXTURE2D Texture;
+    int FirstRow, FramesCount; // Rows of the shared frame table
+    SpriteAnimation* Animations;
+    int AnimationsCount, AnimationsCapacity;
+};
+
+// One entry per instance in each array, UpdateAnimator walks them front to back
+struct ANIMATOR {
+    SPRITE_SHEET* Sheet;
+    int* Animation;
+    float* Time; // Seconds into the animation, wrapped for looping ones
+    int32_t* Frame; // 1 + frame table row, what the instance record carries
+    int Count, Capacity;
+};
+
+struct TEXTURE_ARRAY {
+    uint32_t Handle;
+    int Width, Height;
+    int Layers, UsedLayers;
+    bool MipmapsDirty; // Layers were added since the chain was generated, it's rebuilt when the array is next bound
+};
+
 /** Haxxor */
+#ifdef HAXXOR_COMPACT_VERTEX
+const GLchar* vertSource = 
+    "#version 430 core\n"
+    "layout(location = 0) in vec2 a_Position;\n"
+    "layout(location = 1) in vec4 a_Color;\n"
+    "layout(location = 2) in vec2 a_TexCoords;\n"
+    "layout(location = 3) in int a_TexId;\n"
+    "uniform mat4 u_WorldMatrix;\n"
+    "out vec4 v_Color;\n"
+    "out vec2 v_TexCoords;\n"
+    "flat out int v_TexId;\n"
+    "void main()\n"
+    "{"
+        "v_Color = a_Color;\n"
+        "v_TexCoords = a_TexCoords;\n"
+        "v_TexId = a_TexId;\n"
+        "gl_Position = u_WorldMatrix * vec4(a_Position, 0.0, 1.0);\n"
+    "}";
+#define FRAG_TEXID_INPUT "flat in int v_TexId;\n"
+#else
 const GLchar* vertSource = 
     "#version 430 core\n"
     "layout(location = 0) in vec3 a_Position;\n"
@@ -35,7 +513,7 @@ const GLchar* vertSource =
     "uniform mat4 u_WorldMatrix;\n"
     "out vec4 v_Color;\n"
     "out vec2 v_TexCoords;\n"
-    "out float v_TexId;\n"
+    "flat out float v_TexId;\n"
     "void main()\n"
     "{"
         "v_Color = a_Color;\n"
@@ -43,18 +521,56 @@ const GLchar* vertSource =
         "v_TexId = a_TexId;\n"
         "gl_Position = u_WorldMatrix * vec4(a_Position, 1.0);\n"
     "}";
+#define FRAG_TEXID_INPUT "flat in float v_TexId;\n"
+#endif
+
+const GLchar* instanceVertSource = 
+    "#version 430 core\n"
+    "layout(location = 0) in vec2 a_Corner;\n"
+    "layout(location = 1) in vec4 a_Rect;\n"
+    "layout(location = 2) in vec4 a_Color;\n"
+    "layout(location = 3) in vec4 a_TexRect;\n"
+    "layout(location = 4) in int a_TexId;\n"
+    "layout(location = 5) in vec2 a_Pivot;\n"
+    "layout(location = 6) in float a_Rotation;\n"
+    "layout(location = 7) in int a_Frame;\n"
+    "uniform samplerBuffer u_Frames;\n"
+    "uniform mat4 u_WorldMatrix;\n"
+    "out vec4 v_Color;\n"
+    "out vec2 v_TexCoords;\n"
+    "flat out int v_TexId;\n"
+    "void main()\n"
+    "{"
+        "v_Color = a_Color;\n"
+        "vec4 texRect = a_Frame > 0 ? texelFetch(u_Frames, a_Frame - 1) : a_TexRect;\n"
+        "v_TexCoords = mix(texRect.xy, texRect.zw, a_Corner);\n"
+        "v_TexId = a_TexId;\n"
+        "vec2 local = a_Corner * a_Rect.zw - a_Pivot;\n"
+        "float c = cos(a_Rotation);\n"
+        "float s = sin(a_Rotation);\n"
+        "vec2 position = a_Rect.xy + a_Pivot + vec2(c * local.x - s * local.y, s * local.x + c * local.y);\n"
+        "gl_Position = u_WorldMatrix * vec4(position, 0.0, 1.0);\n"
+    "}";
 
+// Texture ids at or above this address a texture array layer: ((slot + 1) << 16) | layer
+#define TEXTURE_ARRAY_ID(slot, layer) ((((slot) + 1) << 16) | (layer))
+
+// Formatted with the texture slot input and counts at init since GLSL needs constant sampler array sizes
 const GLchar* fragSource =
     "#version 430 core\n"
     "layout(location = 0) out vec4 outColor;\n"
     "in vec4 v_Color;\n"
     "in vec2 v_TexCoords;\n"
-    "in float v_TexId;\n"
-    "uniform sampler2D u_Textures[10];\n" // make a more dynamic texture system
+    "%s"
+    "uniform sampler2D u_Textures[%d];\n"
+    "uniform sampler2DArray u_TextureArrays[%d];\n"
     "void main()\n"
     "{\n"
-        "if(v_TexId >= 0) {\n"
-        "outColor = texture(u_Textures[int(v_TexId)], v_TexCoords);\n"
+        "int id = int(v_TexId);\n"
+        "if(id >= 65536) {\n"
+        "outColor = texture(u_TextureArrays[(id >> 16) - 1], vec3(v_TexCoords, float(id & 0xFFFF)));\n"
+        "} else if(id >= 0) {\n"
+        "outColor = texture(u_Textures[id], v_TexCoords);\n"
         "} else {\n"
         "outColor = v_Color;\n"
         "}\n"
@@ -64,18 +580,116 @@ typedef struct Application {
     bool Initialized;
     struct {
         GLFWwindow* Handle;
+        int Width, Height;
+        uint32_t Framebuffer, Renderbuffer; // Offscreen target in headless builds
     } Surface;
     struct {
-        uint32_t VAO, VBO, IBO, Shader;
+        uint32_t VAO, IBO, Shader;
+        HXGLRingBuffer VertexRing;
+        int TextureSlots; // GL_MAX_TEXTURE_IMAGE_UNITS minus the array slots and the frame table, clamped to MAXIMUM_TEXTURE_SLOT
+        TEXTURE2D Textures[MAXIMUM_TEXTURE_SLOT]; // Texture bound to each slot in the current batch
         int NextAvailSlot;
-        Vertex Vertices[MAXIMUM_VERTICES];
-        uint32_t Elements[MAXIMUM_ELEMENTS];
-        uint32_t ElementsCount, VerticesCount;
+        // Array slots use the units after the 2D slots and stay bound across batches and frames
+        TEXTURE_ARRAY* TextureArrays[MAXIMUM_TEXTURE_ARRAY_SLOT];
+        int NextAvailArraySlot;
+        Vertex* Vertices; // Mapped segment of VertexRing
+        uint32_t VerticesCount;
+        BATCH_MODE Mode;
+        bool Drawing;
+        uint32_t InstanceVAO, QuadVBO, InstanceShader;
+        HXGLRingBuffer InstanceRing;
+        Instance* Instances; // Mapped segment of InstanceRing
+        uint32_t InstancesCount;
+        BLEND_MODE Blend;
+        RENDER_STATS Stats;
+        QuadKernel ExpandQuads; // Picked for the CPU at init, used by the bulk draw functions
+        MAT4 Projection;
+        int WorldMatrixLoc, InstanceWorldMatrixLoc;
+        Bounds View; // World space box around what the camera sees, rectangles outside it are culled
+        MAT4 ViewMatrix; // Camera transform the world matrix was built from
     } Renderer;
+    struct {
+        bool Started, Quit;
+        Thread Workers[MAXIMUM_LOADER_THREADS];
+        int WorkersCount;
+        Mutex Lock;
+        Condition Wake;
+        AsyncQueue Pending; // Waiting for a worker
+        AsyncQueue Decoded; // Waiting for the render thread
+        AsyncQueue Uploads; // Render thread only
+        HXGLRingBuffer Staging; // Pixel unpack buffer the uploads stream through
+        double Budget; // Seconds of upload work per frame
+    } Loader;
+    struct {
+        float (*Rows)[4]; // u0, v0, u1, v1 of every sprite sheet frame, mirrored in Buffer
+        int Count, Capacity; // Buffer is allocated for Capacity rows
+        FrameRange* Free; // Sorted, never touching each other or Count
+        int FreeCount, FreeCapacity;
+        uint32_t Texture, Buffer; // Buffer texture the instance shader fetches the rows from
+        int Unit; // Texture unit after the array slots, the frame table stays bound there
+    } Frames;
+    struct {
+        Mutex Lock; // Only guards Submitted, recording itself never locks
+        COMMAND_BUFFER* Submitted;
+        int NextId;
+        bool Sorting;
+        COMMAND_BUFFER** Buffers; // Scratch for the merge
+        int BuffersCapacity;
+        CommandRef* Refs;
+        int RefsCapacity;
+        const COMMAND_BUFFER* Camera; // Buffer whose camera is in place while merging, NULL before the first one
+    } Commands;
+    struct {
+        bool Enabled, InFrame, Loaded;
+        bool FramePending; // The last profiled frame waits for the next BeginDraw to close its PROFILE_FRAME zone
+        uint64_t Frame;
+        FRAME_PROFILE History[MAXIMUM_PROFILE_FRAMES]; // Indexed by Frame % MAXIMUM_PROFILE_FRAMES
+        ProfileEvent* Events; // Newest MAXIMUM_PROFILE_EVENTS CPU zones, for the trace
+        uint64_t EventsCount;
+        uint32_t GpuQueries[PROFILE_GPU_LATENCY][PROFILE_GPU_TIMERS];
+        int GpuCount[PROFILE_GPU_LATENCY];
+        uint64_t GpuFrame[PROFILE_GPU_LATENCY];
+    } Profiler;
 } Application;
 
 static Application APP = {0};
 
+static uint32_t LoadBatchShader(const char* vert, const char* texIdInput, MAT4 proj, int* worldMatrixLoc)
+{
+    char fragSourceSized[1024];
+    snprintf(fragSourceSized, sizeof(fragSourceSized), fragSource, texIdInput, APP.Renderer.TextureSlots, MAXIMUM_TEXTURE_ARRAY_SLOT);
+    uint32_t shader = hxglLoadShader(vert, fragSourceSized);
+
+    *worldMatrixLoc = hxglGetUniformLocation(shader, "u_WorldMatrix");
+    hxglSetUniformMat4(*worldMatrixLoc, proj.elements);
+
+    // Slot i always samples texture unit i, so the samplers never change after this
+    int samplers[MAXIMUM_TEXTURE_SLOT + MAXIMUM_TEXTURE_ARRAY_SLOT];
+    for(int i = 0; i < APP.Renderer.TextureSlots; i++) samplers[i] = i;
+    int utexloc = hxglGetUniformLocation(shader, "u_Textures");
+    hxglSetUniform(utexloc, samplers, HXGL_SHADER_UNIFORM_INT, APP.Renderer.TextureSlots);
+    for(int i = 0; i < MAXIMUM_TEXTURE_ARRAY_SLOT; i++) samplers[i] = APP.Renderer.TextureSlots + i;
+    int uarrloc = hxglGetUniformLocation(shader, "u_TextureArrays");
+    hxglSetUniform(uarrloc, samplers, HXGL_SHADER_UNIFORM_INT, MAXIMUM_TEXTURE_ARRAY_SLOT);
+    return shader;
+}
+
+// Attributes of the bound vertex array, reading Vertex records from the bound vertex buffer
+static void SetVertexLayout()
+{
+#ifdef HAXXOR_COMPACT_VERTEX
+    hxglSetVertexAttribute(0, 2, HXGL_FLOAT, false, sizeof(Vertex), (void*)offsetof(Vertex, Pos));
+    hxglSetVertexAttribute(1, 4, HXGL_UNSIGNED_BYTE, true, sizeof(Vertex), (void*)offsetof(Vertex, Color));
+    hxglSetVertexAttribute(2, 2, HXGL_UNSIGNED_SHORT, true, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
+    hxglSetVertexAttributeInteger(3, 1, HXGL_INT, sizeof(Vertex), (void*)offsetof(Vertex, TexID));
+#else
+    hxglSetVertexAttribute(0, 3, HXGL_FLOAT, false, sizeof(Vertex), (void*)offsetof(Vertex, Pos));
+    hxglSetVertexAttribute(1, 4, HXGL_FLOAT, false, sizeof(Vertex), (void*)offsetof(Vertex, Color));
+    hxglSetVertexAttribute(2, 2, HXGL_FLOAT, false, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
+    hxglSetVertexAttribute(3, 1, HXGL_FLOAT, false, sizeof(Vertex), (void*)offsetof(Vertex, TexID));
+#endif
+}
+
 bool InitHaxxor(const char* name, float width, float height)
 {
     if(APP.Initialized) return false; // Haxxor has been initialized
@@ -84,39 +698,105 @@ bool InitHaxxor(const char* name, float width, float height)
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+#ifdef HAXXOR_HEADLESS
+    // GLFW is built for its null platform, OSMesa renders on the CPU so llvmpipe gives the same pixels everywhere
+    glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_OSMESA_CONTEXT_API);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+#endif
     APP.Surface.Handle = glfwCreateWindow((int)width, (int)height, name, NULL, NULL);
     if(APP.Surface.Handle == NULL) return false; // Failed to create window
     glfwMakeContextCurrent(APP.Surface.Handle);
+    APP.Surface.Width = (int)width;
+    APP.Surface.Height = (int)height;
 
     // Renderer Initialization
     hxglUseExtension(glfwGetProcAddress);
     if(!hxglInit()) return false;
-    APP.Renderer.Shader = hxglLoadShader(vertSource, fragSource);
-    memset(APP.Renderer.Vertices, 0, sizeof(APP.Renderer.Vertices));
-    memset(APP.Renderer.Elements, 0, sizeof(APP.Renderer.Elements));
+#ifdef HAXXOR_HEADLESS
+    APP.Surface.Framebuffer = hxglLoadFramebuffer(APP.Surface.Width, APP.Surface.Height, &APP.Surface.Renderbuffer);
+    if(APP.Surface.Framebuffer == 0) return false;
+#endif
+    APP.Renderer.TextureSlots = hxglGetMaxTextureSlots() - MAXIMUM_TEXTURE_ARRAY_SLOT - 1;
+    if(APP.Renderer.TextureSlots > MAXIMUM_TEXTURE_SLOT) APP.Renderer.TextureSlots = MAXIMUM_TEXTURE_SLOT;
+    APP.Frames.Unit = APP.Renderer.TextureSlots + MAXIMUM_TEXTURE_ARRAY_SLOT;
+    MAT4 proj = Mat4Orthographic(0.0f, width, height, 0.0f, -1.0f, 1.0f);
+    APP.Renderer.Projection = proj;
+    APP.Renderer.Shader = LoadBatchShader(vertSource, FRAG_TEXID_INPUT, proj, &APP.Renderer.WorldMatrixLoc);
+    APP.Renderer.InstanceShader = LoadBatchShader(instanceVertSource, "flat in int v_TexId;\n", proj, &APP.Renderer.InstanceWorldMatrixLoc);
+    hxglSetUniform(hxglGetUniformLocation(APP.Renderer.InstanceShader, "u_Frames"), &APP.Frames.Unit, HXGL_SHADER_UNIFORM_INT, 1);
+    APP.Renderer.View = (Bounds){ 0.0f, 0.0f, width, height };
+    APP.Renderer.ViewMatrix = Mat4Identity();
     APP.Renderer.VAO = hxglLoadVertexArray();
-    APP.Renderer.VBO = hxglLoadVertexBuffer(NULL, sizeof(APP.Renderer.Vertices), true);
-    APP.Renderer.IBO = hxglLoadIndexBuffer(NULL, sizeof(APP.Renderer.Elements), true);
     hxglEnableVertexArray(APP.Renderer.VAO);
-    hxglEnableVertexBuffer(APP.Renderer.VBO);
-    hxglSetVertexAttribute(0, 3, HXGL_FLOAT, false, sizeof(Vertex), (void*)offsetof(Vertex, Pos));
-    hxglSetVertexAttribute(1, 4, HXGL_FLOAT, false, sizeof(Vertex), (void*)offsetof(Vertex, Color));
-    hxglSetVertexAttribute(2, 2, HXGL_FLOAT, false, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
-    hxglSetVertexAttribute(3, 1, HXGL_FLOAT, false, sizeof(Vertex), (void*)offsetof(Vertex, TexID));
+    if(!hxglLoadRingBuffer(&APP.Renderer.VertexRing, HXGL_VERTEX_BUFFER, HAXXOR_FRAME_BATCHES * MAXIMUM_VERTICES * sizeof(Vertex))) return false;
 
-    uint32_t wmloc = hxglGetUniformLocation(APP.Renderer.Shader, "u_WorldMatrix");
-    MAT4 proj = Mat4Orthographic(0.0f, width, height, 0.0f, -1.0f, 1.0f);
-    hxglSetUniformMat4(wmloc, proj.elements);
+    Element* elements = malloc(MAXIMUM_ELEMENTS * sizeof(Element));
+    if(elements == NULL) return false;
+    for(int quad = 0; quad < MAXIMUM_QUADS; quad++)
+    {
+        Element vertex = (Element)(quad * 4);
+        elements[quad * 6 + 0] = vertex + 0;
+        elements[quad * 6 + 1] = vertex + 1;
+        elements[quad * 6 + 2] = vertex + 2;
+        elements[quad * 6 + 3] = vertex + 2;
+        elements[quad * 6 + 4] = vertex + 3;
+        elements[quad * 6 + 5] = vertex + 0;
+    }
+    APP.Renderer.IBO = hxglLoadIndexBuffer(elements, MAXIMUM_ELEMENTS * sizeof(Element), false);
+    free(elements);
+
+    hxglEnableVertexBuffer(APP.Renderer.VertexRing.Buffer);
+    SetVertexLayout();
+
+    // Instanced path, the unit quad is the only per-vertex data
+    const VEC2 corners[6] = { {{ 0.0f, 0.0f }}, {{ 1.0f, 0.0f }}, {{ 1.0f, 1.0f }}, {{ 1.0f, 1.0f }}, {{ 0.0f, 1.0f }}, {{ 0.0f, 0.0f }} };
+    APP.Renderer.InstanceVAO = hxglLoadVertexArray();
+    hxglEnableVertexArray(APP.Renderer.InstanceVAO);
+    APP.Renderer.QuadVBO = hxglLoadVertexBuffer(corners, sizeof(corners), false);
+    hxglSetVertexAttribute(0, 2, HXGL_FLOAT, false, sizeof(VEC2), (void*)0);
+    if(!hxglLoadRingBuffer(&APP.Renderer.InstanceRing, HXGL_VERTEX_BUFFER, HAXXOR_FRAME_BATCHES * MAXIMUM_QUADS * sizeof(Instance))) return false;
+    hxglSetVertexAttribute(1, 4, HXGL_FLOAT, false, sizeof(Instance), (void*)offsetof(Instance, Rect));
+    hxglSetVertexAttribute(2, 4, HXGL_UNSIGNED_BYTE, true, sizeof(Instance), (void*)offsetof(Instance, Color));
+    hxglSetVertexAttribute(3, 4, HXGL_UNSIGNED_SHORT, true, sizeof(Instance), (void*)offsetof(Instance, TexRect));
+    hxglSetVertexAttributeInteger(4, 1, HXGL_INT, sizeof(Instance), (void*)offsetof(Instance, TexID));
+    hxglSetVertexAttribute(5, 2, HXGL_FLOAT, false, sizeof(Instance), (void*)offsetof(Instance, Pivot));
+    hxglSetVertexAttribute(6, 1, HXGL_FLOAT, false, sizeof(Instance), (void*)offsetof(Instance, Rotation));
+    hxglSetVertexAttributeInteger(7, 1, HXGL_INT, sizeof(Instance), (void*)offsetof(Instance, Frame));
+    for(int i = 1; i <= 7; i++) hxglSetVertexAttributeDivisor(i, 1);
 
     APP.Renderer.NextAvailSlot = 0;
+    APP.Renderer.NextAvailArraySlot = 0;
+    APP.Renderer.Mode = BATCH_MODE_VERTICES;
+    APP.Renderer.ExpandQuads = SelectQuadKernel();
+    MutexInit(&APP.Commands.Lock);
+    APP.Loader.Budget = DEFAULT_ASYNC_UPLOAD_BUDGET / 1000.0;
 
     APP.Initialized = true;
     return true;
 }
 
+static void StopAsyncLoader();
+
 void ShutHaxxor()
 {
     if(!APP.Initialized) return;
+    StopAsyncLoader();
+    MutexDestroy(&APP.Commands.Lock);
+    free(APP.Commands.Buffers);
+    free(APP.Commands.Refs);
+    memset(&APP.Commands, 0, sizeof(APP.Commands));
+    if(APP.Frames.Texture) hxglDropTextureBuffer(APP.Frames.Texture, APP.Frames.Buffer);
+    free(APP.Frames.Rows);
+    free(APP.Frames.Free);
+    memset(&APP.Frames, 0, sizeof(APP.Frames));
+    if(APP.Profiler.Loaded) hxglDropQueries(&APP.Profiler.GpuQueries[0][0], PROFILE_GPU_LATENCY * PROFILE_GPU_TIMERS);
+    free(APP.Profiler.Events);
+    memset(&APP.Profiler, 0, sizeof(APP.Profiler));
+    hxglDropRingBuffer(&APP.Renderer.VertexRing);
+    hxglDropIndexBuffer(APP.Renderer.IBO);
+    hxglDropRingBuffer(&APP.Renderer.InstanceRing);
+    hxglDropVertexBuffer(APP.Renderer.QuadVBO);
+    if(APP.Surface.Framebuffer) hxglDropFramebuffer(APP.Surface.Framebuffer, APP.Surface.Renderbuffer);
     glfwDestroyWindow(APP.Surface.Handle);
     glfwTerminate();   
     APP.Initialized = false;
@@ -134,157 +814,2204 @@ void PollEvents()
 
 void SwapBuffers()
 {
+    // Nothing to present offscreen, the frame stays in the framebuffer until the next BeginDraw clears it
+    if(APP.Surface.Framebuffer) return;
     glfwSwapBuffers(APP.Surface.Handle);
 }
 
-void BeginDraw()
+double GetTime()
 {
-    // Clean up
-    hxglClear();
-    memset(APP.Renderer.Vertices, 0, sizeof(APP.Renderer.Vertices));
-    memset(APP.Renderer.Elements, 0, sizeof(APP.Renderer.Elements));
-    APP.Renderer.VerticesCount = 0;
-    APP.Renderer.ElementsCount = 0;
-    APP.Renderer.NextAvailSlot = 0;
-    // hxglDisableVertexArray();
-    // hxglDisableVertexBuffer();
-    // hxglDisableIndexBuffer();
-    // hxglDisableShader();
+    return glfwGetTime();
 }
 
-void EndDraw()
+bool IsHeadless()
 {
-    // Draw to screen
-    hxglEnableShader(APP.Renderer.Shader);
-    hxglEnableVertexArray(APP.Renderer.VAO);
-    hxglEnableVertexBuffer(APP.Renderer.VBO);
-    hxglEnableIndexBuffer(APP.Renderer.IBO);
+    return APP.Surface.Framebuffer != 0;
+}
+
+int GetFrameWidth()
+{
+    return APP.Surface.Width;
+}
+
+int GetFrameHeight()
+{
+    return APP.Surface.Height;
+}
 
-    hxglUpdateVertexBuffer(APP.Renderer.VBO, APP.Renderer.Vertices, APP.Renderer.VerticesCount * sizeof(Vertex), 0);
-    hxglUpdateIndexBuffer(APP.Renderer.IBO, APP.Renderer.Elements, APP.Renderer.ElementsCount * sizeof(uint32_t), 0);
+// Top row first, pixels must hold GetFrameWidth() * GetFrameHeight() RGBA8 texels
+bool ReadFramePixels(void* pixels)
+{
+    // Once swapped, a window's front buffer is undefined wherever it's covered or offscreen, only the headless target is reliable
+    if(!APP.Initialized || APP.Surface.Framebuffer == 0) return false;
+    int rowSize = APP.Surface.Width * 4;
+    uint8_t* rows = malloc((size_t)rowSize * APP.Surface.Height);
+    if(rows == NULL) return false;
+    hxglReadPixels(0, 0, APP.Surface.Width, APP.Surface.Height, rows);
+    for(int y = 0; y < APP.Surface.Height; y++)
+        memcpy((uint8_t*)pixels + (size_t)y * rowSize, rows + (size_t)(APP.Surface.Height - 1 - y) * rowSize, rowSize);
+    free(rows);
+    return true;
+}
 
-    int utexloc = hxglGetUniformLocation(APP.Renderer.Shader, "u_Textures");
-    int* samplers = malloc(sizeof(int) * 10);
-    for(int i = 0; i < 10; i++)
+// 64-bit FNV-1a of the last frame's pixels, only meaningful across runs on the same rasterizer, 0 when windowed
+uint64_t GetFrameChecksum()
+{
+    size_t size = (size_t)APP.Surface.Width * APP.Surface.Height * 4;
+    uint8_t* pixels = malloc(size);
+    if(pixels == NULL || !ReadFramePixels(pixels))
     {
-        if(i < APP.Renderer.NextAvailSlot) samplers[i] = i;
-        else samplers[i] = -1;
+        free(pixels);
+        return 0;
     }
-    hxglSetUniform(utexloc, samplers, HXGL_SHADER_UNIFORM_INT, APP.Renderer.NextAvailSlot);
+    uint64_t hash = 14695981039346656037ULL;
+    for(size_t i = 0; i < size; i++)
+    {
+        hash ^= pixels[i];
+        hash *= 1099511628211ULL;
+    }
+    free(pixels);
+    return hash;
+}
 
-    hxglDrawVertexArrayElements(0, APP.Renderer.ElementsCount, 0);
-    SwapBuffers();
+/** Profiling */
+static FRAME_PROFILE* CurrentProfile()
+{
+    return &APP.Profiler.History[APP.Profiler.Frame % MAXIMUM_PROFILE_FRAMES];
 }
 
+// Zero when profiling is off, so the disabled path costs a branch instead of a clock read
+static double ProfileNow()
+{
+    return APP.Profiler.InFrame ? glfwGetTime() : 0.0;
+}
 
-void DrawRectangle(RECTANGLE r, COLOR c)
+static void EndProfileZone(PROFILE_ZONE zone, double start)
 {
-    APP.Renderer.Elements[APP.Renderer.ElementsCount + 0] = APP.Renderer.VerticesCount + 0;
-    APP.Renderer.Elements[APP.Renderer.ElementsCount + 1] = APP.Renderer.VerticesCount + 1;
-    APP.Renderer.Elements[APP.Renderer.ElementsCount + 2] = APP.Renderer.VerticesCount + 2;
-    APP.Renderer.Elements[APP.Renderer.ElementsCount + 3] = APP.Renderer.VerticesCount + 2;
-    APP.Renderer.Elements[APP.Renderer.ElementsCount + 4] = APP.Renderer.VerticesCount + 3;
-    APP.Renderer.Elements[APP.Renderer.ElementsCount + 5] = APP.Renderer.VerticesCount + 0;
-    APP.Renderer.ElementsCount += 6;
-
-    VEC4 rcol = ColorToVec4(c);
-    APP.Renderer.Vertices[APP.Renderer.VerticesCount + 0].Pos.x = r.x;
-    APP.Renderer.Vertices[APP.Renderer.VerticesCount + 0].Pos.y = r.y;
-    APP.Renderer.Vertices[APP.Renderer.VerticesCount + 0].Color = rcol;
-    APP.Renderer.Vertices[APP.Renderer.VerticesCount + 0].TexID = -1;
-
-    APP.Renderer.Vertices[APP.Renderer.VerticesCount + 1].Pos.x = r.x + r.w;
-    APP.Renderer.Vertices[APP.Renderer.VerticesCount + 1].Pos.y = r.y;
-    APP.Renderer.Vertices[APP.Renderer.VerticesCount + 1].Color = rcol;
-    APP.Renderer.Vertices[APP.Renderer.VerticesCount + 1].TexID = -1;
-
-    APP.Renderer.Vertices[APP.Renderer.VerticesCount + 2].Pos.x = r.x + r.w;
-    APP.Renderer.Vertices[APP.Renderer.VerticesCount + 2].Pos.y = r.y + r.h;
-    APP.Renderer.Vertices[APP.Renderer.VerticesCount + 2].Color = rcol;
-    APP.Renderer.Vertices[APP.Renderer.VerticesCount + 2].TexID = -1;
-
-    APP.Renderer.Vertices[APP.Renderer.VerticesCount + 3].Pos.x = r.x;
-    APP.Renderer.Vertices[APP.Renderer.VerticesCount + 3].Pos.y = r.y + r.h;
-    APP.Renderer.Vertices[APP.Renderer.VerticesCount + 3].Color = rcol;
-    APP.Renderer.Vertices[APP.Renderer.VerticesCount + 3].TexID = -1;
+    if(!APP.Profiler.InFrame) return;
+    double duration = glfwGetTime() - start;
+    CurrentProfile()->Milliseconds[zone] += duration * 1000.0;
+    ProfileEvent* event = &APP.Profiler.Events[APP.Profiler.EventsCount++ % MAXIMUM_PROFILE_EVENTS];
+    event->Zone = zone;
+    event->Start = start;
+    event->Duration = duration;
+}
 
-    APP.Renderer.VerticesCount += 4;
+static void BeginGpuZone()
+{
+    if(!APP.Profiler.InFrame) return;
+    int slot = APP.Profiler.Frame % PROFILE_GPU_LATENCY;
+    if(APP.Profiler.GpuCount[slot] >= PROFILE_GPU_TIMERS) return;
+    hxglBeginTimeElapsed(APP.Profiler.GpuQueries[slot][APP.Profiler.GpuCount[slot]]);
 }
 
-void DrawRectangleTex(RECTANGLE r, TEXTURE2D t)
+static void EndGpuZone()
 {
-    APP.Renderer.Elements[APP.Renderer.ElementsCount + 0] = APP.Renderer.VerticesCount + 0;
-    APP.Renderer.Elements[APP.Renderer.ElementsCount + 1] = APP.Renderer.VerticesCount + 1;
-    APP.Renderer.Elements[APP.Renderer.ElementsCount + 2] = APP.Renderer.VerticesCount + 2;
-    APP.Renderer.Elements[APP.Renderer.ElementsCount + 3] = APP.Renderer.VerticesCount + 2;
-    APP.Renderer.Elements[APP.Renderer.ElementsCount + 4] = APP.Renderer.VerticesCount + 3;
-    APP.Renderer.Elements[APP.Renderer.ElementsCount + 5] = APP.Renderer.VerticesCount + 0;
-    APP.Renderer.ElementsCount += 6;
-
-    hxglEnableTexture(t, APP.Renderer.NextAvailSlot);
-    APP.Renderer.Vertices[APP.Renderer.VerticesCount + 0].Pos.x = r.x;
-    APP.Renderer.Vertices[APP.Renderer.VerticesCount + 0].Pos.y = r.y;
-    APP.Renderer.Vertices[APP.Renderer.VerticesCount + 0].TexCoords = Vec2Create(0.0f, 0.0f);
-    APP.Renderer.Vertices[APP.Renderer.VerticesCount + 0].TexID = APP.Renderer.NextAvailSlot;
-
-    APP.Renderer.Vertices[APP.Renderer.VerticesCount + 1].Pos.x = r.x + r.w;
-    APP.Renderer.Vertices[APP.Renderer.VerticesCount + 1].Pos.y = r.y;
-    APP.Renderer.Vertices[APP.Renderer.VerticesCount + 1].TexCoords = Vec2Create(1.0f, 0.0f);
-    APP.Renderer.Vertices[APP.Renderer.VerticesCount + 1].TexID = APP.Renderer.NextAvailSlot;
-
-    APP.Renderer.Vertices[APP.Renderer.VerticesCount + 2].Pos.x = r.x + r.w;
-    APP.Renderer.Vertices[APP.Renderer.VerticesCount + 2].Pos.y = r.y + r.h;
-    APP.Renderer.Vertices[APP.Renderer.VerticesCount + 2].TexCoords = Vec2Create(1.0f, 1.0f);
-    APP.Renderer.Vertices[APP.Renderer.VerticesCount + 2].TexID = APP.Renderer.NextAvailSlot;
-
-    APP.Renderer.Vertices[APP.Renderer.VerticesCount + 3].Pos.x = r.x;
-    APP.Renderer.Vertices[APP.Renderer.VerticesCount + 3].Pos.y = r.y + r.h;
-    APP.Renderer.Vertices[APP.Renderer.VerticesCount + 3].TexCoords = Vec2Create(0.0f, 1.0f);
-    APP.Renderer.Vertices[APP.Renderer.VerticesCount + 3].TexID = APP.Renderer.NextAvailSlot;
-
-    APP.Renderer.NextAvailSlot += 1;
-    APP.Renderer.VerticesCount += 4;
+    if(!APP.Profiler.InFrame) return;
+    int slot = APP.Profiler.Frame % PROFILE_GPU_LATENCY;
+    if(APP.Profiler.GpuCount[slot] >= PROFILE_GPU_TIMERS) return;
+    hxglEndTimeElapsed();
+    APP.Profiler.GpuCount[slot] += 1;
 }
 
-IMAGE* LoadImage(const void* data, int width, int height)
+// The queries were issued PROFILE_GPU_LATENCY frames ago so the results are almost always there already
+static void ResolveGpuZones(int slot)
 {
-    IMAGE* img = malloc(sizeof(IMAGE));
-    img->Width = width;
-    img->Height = height;
-    img->Data = (void*) data;
-    img->LoadedFromFile = false;
-    return img;
+    if(APP.Profiler.GpuCount[slot] == 0) return;
+    uint64_t elapsed = 0;
+    for(int i = 0; i < APP.Profiler.GpuCount[slot]; i++) elapsed += hxglGetQueryResult(APP.Profiler.GpuQueries[slot][i]);
+    APP.Profiler.GpuCount[slot] = 0;
+
+    FRAME_PROFILE* frame = &APP.Profiler.History[APP.Profiler.GpuFrame[slot] % MAXIMUM_PROFILE_FRAMES];
+    if(frame->Frame == APP.Profiler.GpuFrame[slot]) frame->Milliseconds[PROFILE_GPU_DRAW] = elapsed / 1000000.0;
 }
 
-IMAGE* LoadImageFromFile(const char* path, bool flip)
+static double BeginProfileFrame()
 {
-    stbi_set_flip_vertically_on_load(flip);
-    int w, h;
-    uint8_t* data = stbi_load(path, &w, &h, NULL, 4);
-    IMAGE* img = LoadImage((void*)data, w, h);
-    img->LoadedFromFile = true;
-    return img;
+    // The time profiling was off isn't part of the frame before it
+    if(!APP.Profiler.Enabled)
+    {
+        APP.Profiler.FramePending = false;
+        return 0.0;
+    }
+    double now = glfwGetTime();
+    if(APP.Profiler.FramePending)
+    {
+        FRAME_PROFILE* last = CurrentProfile();
+        last->Milliseconds[PROFILE_FRAME] = (now - last->Start) * 1000.0;
+        APP.Profiler.FramePending = false;
+    }
+    APP.Profiler.Frame += 1;
+    int slot = APP.Profiler.Frame % PROFILE_GPU_LATENCY;
+    ResolveGpuZones(slot);
+    APP.Profiler.GpuFrame[slot] = APP.Profiler.Frame;
+
+    FRAME_PROFILE* frame = CurrentProfile();
+    memset(frame, 0, sizeof(FRAME_PROFILE));
+    frame->Frame = APP.Profiler.Frame;
+    frame->Start = now;
+    APP.Profiler.InFrame = true;
+    return now;
 }
 
-RECTANGLE GetImageShape(const IMAGE* img)
+static void EndProfileFrame()
 {
-    RECTANGLE r = {0};
-    r.w = (float) img->Width;
-    r.h = (float) img->Height;
-    r.x = 0.0f;
-    r.y = 0.0f;
-    return r;
+    if(!APP.Profiler.InFrame) return;
+    CurrentProfile()->Stats = APP.Renderer.Stats;
+    APP.Profiler.InFrame = false;
+    APP.Profiler.FramePending = true;
 }
 
-void DestroyImage(IMAGE* image)
+void SetProfiling(bool enabled)
 {
-    stbi_image_free(image->Data);
-    free(image);
-    image = NULL;
+    if(enabled && !APP.Profiler.Loaded)
+    {
+        APP.Profiler.Events = malloc(MAXIMUM_PROFILE_EVENTS * sizeof(ProfileEvent));
+        if(APP.Profiler.Events == NULL) return;
+        hxglLoadQueries(&APP.Profiler.GpuQueries[0][0], PROFILE_GPU_LATENCY * PROFILE_GPU_TIMERS);
+        APP.Profiler.Loaded = true;
+    }
+    // Takes effect from the next BeginDraw, a frame is never half profiled
+    APP.Profiler.Enabled = enabled;
 }
 
-TEXTURE2D LoadTextureFromImage(const IMAGE* image)
+FRAME_PROFILE GetFrameProfile(int framesAgo)
 {
-    TEXTURE2D tex = hxglLoadTexture(image->Data, image->Width, image->Height, HXGL_LINEAR_MIPMAP_LINEAR);
-    return tex;
-}
\ No newline at end of file
+    FRAME_PROFILE profile = {0};
+    // The frame still being drawn isn't complete
+    uint64_t last = APP.Profiler.InFrame ? APP.Profiler.Frame - 1 : APP.Profiler.Frame;
+    if(framesAgo < 0 || framesAgo >= MAXIMUM_PROFILE_FRAMES || (uint64_t)framesAgo >= last) return profile;
+    uint64_t index = last - framesAgo;
+    if(APP.Profiler.History[index % MAXIMUM_PROFILE_FRAMES].Frame == index) profile = APP.Profiler.History[index % MAXIMUM_PROFILE_FRAMES];
+    return profile;
+}
+
+static const char* PROFILE_ZONE_NAMES[PROFILE_ZONE_COUNT] = { "Frame", "BeginDraw", "EndDraw", "Transfer", "SwapBuffers", "GPU Draw" };
+
+// Chrome trace event format, opens in chrome://tracing or ui.perfetto.dev
+bool ExportProfileTrace(const char* path)
+{
+    if(!APP.Profiler.Loaded) return false;
+    FILE* file = fopen(path, "w");
+    if(file == NULL) return false;
+
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"CPU\"}},\n");
+    fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"GPU\"}}");
+    uint64_t first = APP.Profiler.EventsCount > MAXIMUM_PROFILE_EVENTS ? APP.Profiler.EventsCount - MAXIMUM_PROFILE_EVENTS : 0;
+    for(uint64_t i = first; i < APP.Profiler.EventsCount; i++)
+    {
+        const ProfileEvent* event = &APP.Profiler.Events[i % MAXIMUM_PROFILE_EVENTS];
+        fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f}",
+            PROFILE_ZONE_NAMES[event->Zone], event->Start * 1e6, event->Duration * 1e6);
+    }
+    for(int i = 0; i < MAXIMUM_PROFILE_FRAMES; i++)
+    {
+        const FRAME_PROFILE* frame = &APP.Profiler.History[i];
+        if(frame->Frame == 0) continue;
+        const RENDER_STATS* stats = &frame->Stats;
+        double start = frame->Start * 1e6;
+        // The newest frame isn't closed until the next BeginDraw
+        if(frame->Milliseconds[PROFILE_FRAME] > 0.0)
+            fprintf(file, ",\n{\"name\":\"Frame %llu\",\"cat\":\"frame\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f}",
+                (unsigned long long)frame->Frame, start, frame->Milliseconds[PROFILE_FRAME] * 1e3);
+        // GPU timestamps aren't synchronized with the CPU clock, the draw time is placed at the start of its frame
+        if(frame->Milliseconds[PROFILE_GPU_DRAW] > 0.0)
+            fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"gpu\",\"ph\":\"X\",\"pid\":1,\"tid\":2,\"ts\":%.3f,\"dur\":%.3f}",
+                PROFILE_ZONE_NAMES[PROFILE_GPU_DRAW], start, frame->Milliseconds[PROFILE_GPU_DRAW] * 1e3);
+        fprintf(file, ",\n{\"name\":\"Stats\",\"ph\":\"C\",\"pid\":1,\"ts\":%.3f,\"args\":{\"DrawCalls\":%u,\"Quads\":%u,\"Vertices\":%u,\"TextureBinds\":%u,\"Flushes\":%u,\"Culled\":%u}}",
+            start, stats->DrawCalls, stats->Quads, stats->Vertices, stats->TextureBinds, stats->Flushes, stats->Culled);
+    }
+    fprintf(file, "\n]}\n");
+    return fclose(file) == 0;
+}
+
+static void BeginBatch()
+{
+    if(APP.Renderer.Mode == BATCH_MODE_INSTANCED)
+    {
+        hxglEnableVertexArray(APP.Renderer.InstanceVAO);
+        APP.Renderer.Instances = hxglMapRingBuffer(&APP.Renderer.InstanceRing, MAXIMUM_QUADS * sizeof(Instance));
+        APP.Renderer.InstancesCount = 0;
+    }
+    else
+    {
+        hxglEnableVertexArray(APP.Renderer.VAO);
+        APP.Renderer.Vertices = hxglMapRingBuffer(&APP.Renderer.VertexRing, MAXIMUM_VERTICES * sizeof(Vertex));
+        APP.Renderer.VerticesCount = 0;
+    }
+    APP.Renderer.NextAvailSlot = 0;
+}
+
+// Only a mapped-and-unmapped ring has any transfer work here, a persistent one was written in place by the draw calls
+static void UnmapBatchRing(HXGLRingBuffer* ring, int usedSize)
+{
+    if(ring->Persistent)
+    {
+        hxglUnmapRingBuffer(ring, usedSize);
+        return;
+    }
+    double transfer = ProfileNow();
+    hxglUnmapRingBuffer(ring, usedSize);
+    EndProfileZone(PROFILE_TRANSFER, transfer);
+}
+
+static void SubmitBatch()
+{
+    uint32_t quads = 0;
+    if(APP.Renderer.Mode == BATCH_MODE_INSTANCED)
+    {
+        hxglEnableShader(APP.Renderer.InstanceShader);
+        hxglEnableVertexArray(APP.Renderer.InstanceVAO);
+        UnmapBatchRing(&APP.Renderer.InstanceRing, APP.Renderer.InstancesCount * sizeof(Instance));
+        quads = APP.Renderer.InstancesCount;
+        if(quads == 0) return;
+
+        int baseInstance = hxglGetRingBufferOffset(&APP.Renderer.InstanceRing) / sizeof(Instance);
+        BeginGpuZone();
+        hxglDrawVertexArrayInstanced(0, 6, quads, baseInstance);
+        EndGpuZone();
+        APP.Renderer.Stats.Vertices += quads * 6;
+    }
+    else
+    {
+        hxglEnableShader(APP.Renderer.Shader);
+        hxglEnableVertexArray(APP.Renderer.VAO);
+        hxglEnableVertexBuffer(APP.Renderer.VertexRing.Buffer);
+
+        // The draw functions wrote straight into the mapped segment, nothing to upload
+        UnmapBatchRing(&APP.Renderer.VertexRing, APP.Renderer.VerticesCount * sizeof(Vertex));
+        quads = APP.Renderer.VerticesCount / 4;
+        if(quads == 0) return;
+
+        int baseVertex = hxglGetRingBufferOffset(&APP.Renderer.VertexRing) / sizeof(Vertex);
+        BeginGpuZone();
+        hxglDrawVertexArrayElementsBaseVertex(0, quads * 6, ELEMENT_KIND, baseVertex);
+        EndGpuZone();
+        APP.Renderer.Stats.Vertices += quads * 4;
+    }
+    APP.Renderer.Stats.DrawCalls += 1;
+    APP.Renderer.Stats.Quads += quads;
+}
+
+static bool BatchIsFull()
+{
+    if(APP.Renderer.Mode == BATCH_MODE_INSTANCED) return APP.Renderer.InstancesCount >= MAXIMUM_QUADS;
+    return APP.Renderer.VerticesCount + 4 > MAXIMUM_VERTICES;
+}
+
+// Called when the current batch runs out of vertices or texture slots, drawing then continues in a fresh segment
+static void FlushBatch()
+{
+    SubmitBatch();
+    BeginBatch();
+    APP.Renderer.Stats.Flushes += 1;
+}
+
+static void PumpAsyncUploads();
+
+void BeginDraw()
+{
+    double start = BeginProfileFrame();
+    // Clean up
+    hxglClear();
+    double transfer = ProfileNow();
+    PumpAsyncUploads();
+    EndProfileZone(PROFILE_TRANSFER, transfer);
+    memset(&APP.Renderer.Stats, 0, sizeof(RENDER_STATS));
+    BeginBatch();
+    APP.Renderer.Drawing = true;
+    EndProfileZone(PROFILE_BEGIN_DRAW, start);
+    // hxglDisableVertexArray();
+    // hxglDisableVertexBuffer();
+    // hxglDisableIndexBuffer();
+    // hxglDisableShader();
+}
+
+static void MergeCommandBuffers();
+
+void EndDraw()
+{
+    double start = ProfileNow();
+    MergeCommandBuffers();
+    // Draw to screen
+    SubmitBatch();
+    APP.Renderer.Drawing = false;
+    // Every batch of the frame shares one fenced segment, the next frame starts in a fresh one
+    hxglAdvanceRingBuffer(&APP.Renderer.VertexRing);
+    hxglAdvanceRingBuffer(&APP.Renderer.InstanceRing);
+    double swap = ProfileNow();
+    SwapBuffers();
+    EndProfileZone(PROFILE_SWAP_BUFFERS, swap);
+    EndProfileZone(PROFILE_END_DRAW, start);
+    EndProfileFrame();
+}
+
+void SetBlendMode(BLEND_MODE mode)
+{
+    if(APP.Renderer.Blend == mode) return;
+    // The pending batch was recorded for the old blend mode
+    if(APP.Renderer.Drawing)
+    {
+        SubmitBatch();
+        BeginBatch();
+    }
+    APP.Renderer.Blend = mode;
+    if(mode == BLEND_PREMULTIPLIED) hxglSetBlendFactors(HXGL_BLEND_ONE, HXGL_BLEND_ONE_MINUS_SRC_ALPHA);
+    else if(mode == BLEND_ADDITIVE) hxglSetBlendFactors(HXGL_BLEND_SRC_ALPHA, HXGL_BLEND_ONE);
+    else hxglSetBlendFactors(HXGL_BLEND_SRC_ALPHA, HXGL_BLEND_ONE_MINUS_SRC_ALPHA);
+}
+
+void SetBatchMode(BATCH_MODE mode)
+{
+    if(APP.Renderer.Mode == mode) return;
+    if(!APP.Renderer.Drawing)
+    {
+        APP.Renderer.Mode = mode;
+        return;
+    }
+    SubmitBatch();
+    APP.Renderer.Mode = mode;
+    BeginBatch();
+}
+
+// Every batch after this is drawn through view, bounds is the world space box it shows
+static void UseView(MAT4 view, Bounds bounds)
+{
+    // The pending batch was recorded for the previous view
+    if(APP.Renderer.Drawing)
+    {
+        SubmitBatch();
+        BeginBatch();
+    }
+    // Mat4Multiply applies its first argument first
+    MAT4 world = Mat4Multiply(view, APP.Renderer.Projection);
+    hxglEnableShader(APP.Renderer.Shader);
+    hxglSetUniformMat4(APP.Renderer.WorldMatrixLoc, world.elements);
+    hxglEnableShader(APP.Renderer.InstanceShader);
+    hxglSetUniformMat4(APP.Renderer.InstanceWorldMatrixLoc, world.elements);
+    APP.Renderer.ViewMatrix = view;
+    APP.Renderer.View = bounds;
+}
+
+// Only the world matrix uniform changes, vertices stay in world space
+void BeginCamera(CAMERA2D camera)
+{
+    float c = Cos(camera.Rotation);
+    float s = Sin(camera.Rotation);
+    float zoom = camera.Zoom > 0.0f ? camera.Zoom : 1.0f;
+
+    // screen = offset + zoom * rotate(world - target)
+    MAT4 view = Mat4Identity();
+    view.elements[0] = zoom * c;
+    view.elements[1] = zoom * s;
+    view.elements[4] = -zoom * s;
+    view.elements[5] = zoom * c;
+    view.elements[12] = camera.OffsetX - zoom * (c * camera.TargetX - s * camera.TargetY);
+    view.elements[13] = camera.OffsetY - zoom * (s * camera.TargetX + c * camera.TargetY);
+
+    // The screen corners taken back to world space, the view is the box around them
+    VEC2 corners[4] = { { { 0.0f, 0.0f } }, { { (float)APP.Surface.Width, 0.0f } }, { { 0.0f, (float)APP.Surface.Height } }, { { (float)APP.Surface.Width, (float)APP.Surface.Height } } };
+    Vec2TransformArray(corners, corners, 4, Mat4Inverse(view));
+    Bounds bounds = { MATH_INFINITY, MATH_INFINITY, -MATH_INFINITY, -MATH_INFINITY };
+    for(int i = 0; i < 4; i++)
+    {
+        if(corners[i].x < bounds.MinX) bounds.MinX = corners[i].x;
+        if(corners[i].y < bounds.MinY) bounds.MinY = corners[i].y;
+        if(corners[i].x > bounds.MaxX) bounds.MaxX = corners[i].x;
+        if(corners[i].y > bounds.MaxY) bounds.MaxY = corners[i].y;
+    }
+    UseView(view, bounds);
+}
+
+void EndCamera()
+{
+    UseView(Mat4Identity(), (Bounds){ 0.0f, 0.0f, (float)APP.Surface.Width, (float)APP.Surface.Height });
+}
+
+RECTANGLE GetCameraView()
+{
+    const Bounds* view = &APP.Renderer.View;
+    return (RECTANGLE){ view->MinX, view->MinY, view->MaxX - view->MinX, view->MaxY - view->MinY };
+}
+
+RENDER_STATS GetRenderStats()
+{
+    return APP.Renderer.Stats;
+}
+
+// Writes whole vertices, the mapped segment still holds whatever was drawn there HXGL_RING_SEGMENT_COUNT frames ago
+static void WriteQuad(Vertex* v, RECTANGLE r, COLOR c, int texId, RECTANGLE uv)
+{
+#ifdef HAXXOR_COMPACT_VERTEX
+    uint16_t u0 = ToUnorm16(uv.x), v0 = ToUnorm16(uv.y), u1 = ToUnorm16(uv.x + uv.w), v1 = ToUnorm16(uv.y + uv.h);
+    v[0] = (Vertex){ Vec2Create(r.x, r.y), c, { u0, v0 }, texId };
+    v[1] = (Vertex){ Vec2Create(r.x + r.w, r.y), c, { u1, v0 }, texId };
+    v[2] = (Vertex){ Vec2Create(r.x + r.w, r.y + r.h), c, { u1, v1 }, texId };
+    v[3] = (Vertex){ Vec2Create(r.x, r.y + r.h), c, { u0, v1 }, texId };
+#else
+    VEC4 color = ColorToVec4(c);
+    v[0] = (Vertex){ Vec3Create(r.x, r.y, 0.0f), color, Vec2Create(uv.x, uv.y), (float)texId };
+    v[1] = (Vertex){ Vec3Create(r.x + r.w, r.y, 0.0f), color, Vec2Create(uv.x + uv.w, uv.y), (float)texId };
+    v[2] = (Vertex){ Vec3Create(r.x + r.w, r.y + r.h, 0.0f), color, Vec2Create(uv.x + uv.w, uv.y + uv.h), (float)texId };
+    v[3] = (Vertex){ Vec3Create(r.x, r.y + r.h, 0.0f), color, Vec2Create(uv.x, uv.y + uv.h), (float)texId };
+#endif
+}
+
+static bool IsCulled(RECTANGLE r)
+{
+    const Bounds* view = &APP.Renderer.View;
+    return r.x > view->MaxX || r.y > view->MaxY || r.x + r.w < view->MinX || r.y + r.h < view->MinY;
+}
+
+// Textured draws are culled before the texture lookup so culled sprites never take a slot
+static bool CullRectangle(RECTANGLE r)
+{
+    if(!IsCulled(r)) return false;
+    APP.Renderer.Stats.Culled += 1;
+    return true;
+}
+
+static void PushQuad(RECTANGLE r, COLOR c, int texId, RECTANGLE uv)
+{
+    if(BatchIsFull()) FlushBatch();
+    if(APP.Renderer.Mode == BATCH_MODE_INSTANCED)
+    {
+        Instance* instance = APP.Renderer.Instances + APP.Renderer.InstancesCount++;
+        *instance = (Instance){ r, c, { ToUnorm16(uv.x), ToUnorm16(uv.y), ToUnorm16(uv.x + uv.w), ToUnorm16(uv.y + uv.h) }, texId, { 0.0f, 0.0f }, 0.0f, 0 };
+        return;
+    }
+
+    WriteQuad(APP.Renderer.Vertices + APP.Renderer.VerticesCount, r, c, texId, uv);
+    APP.Renderer.VerticesCount += 4;
+}
+
+void DrawRectangle(RECTANGLE r, COLOR c)
+{
+    if(CullRectangle(r)) return;
+    PushQuad(r, c, -1, FULL_UV);
+}
+
+// Returns the slot the texture is bound to in the current batch, binding it to a free one on first use
+static int GetTextureSlot(TEXTURE2D t)
+{
+    // Consecutive sprites usually share a texture, so check the newest slot first
+    for(int slot = APP.Renderer.NextAvailSlot - 1; slot >= 0; slot--)
+    {
+        if(APP.Renderer.Textures[slot] == t) return slot;
+    }
+    if(APP.Renderer.NextAvailSlot >= APP.Renderer.TextureSlots) FlushBatch();
+
+    int slot = APP.Renderer.NextAvailSlot++;
+    APP.Renderer.Textures[slot] = t;
+    hxglEnableTexture(t, slot);
+    APP.Renderer.Stats.TextureBinds += 1;
+    return slot;
+}
+
+// Texture uploads bind on the active unit, which may hold a texture the pending batch samples
+static void ReleaseTextureSlots()
+{
+    if(APP.Renderer.Drawing && APP.Renderer.NextAvailSlot > 0) FlushBatch();
+}
+
+void DrawRectangleTex(RECTANGLE r, TEXTURE2D t)
+{
+    if(CullRectangle(r)) return;
+    // Flushing resets the slots, so make room for the quad before looking the texture up
+    if(BatchIsFull()) FlushBatch();
+    PushQuad(r, WHITE, GetTextureSlot(t), FULL_UV);
+}
+
+void DrawRectangleTexUV(RECTANGLE r, TEXTURE2D t, RECTANGLE uv)
+{
+    if(CullRectangle(r)) return;
+    if(BatchIsFull()) FlushBatch();
+    PushQuad(r, WHITE, GetTextureSlot(t), uv);
+}
+
+// r is already scaled, the pivot is measured from its corner
+static void PushRotatedQuad(RECTANGLE r, float pivotX, float pivotY, float rotation, COLOR c, int texId, RECTANGLE uv)
+{
+    if(BatchIsFull()) FlushBatch();
+    if(APP.Renderer.Mode == BATCH_MODE_INSTANCED)
+    {
+        Instance* instance = APP.Renderer.Instances + APP.Renderer.InstancesCount++;
+        *instance = (Instance){ r, c, { ToUnorm16(uv.x), ToUnorm16(uv.y), ToUnorm16(uv.x + uv.w), ToUnorm16(uv.y + uv.h) }, texId, { pivotX, pivotY }, rotation, 0 };
+        return;
+    }
+
+    // Vertex mode expands every quad on the CPU, so the corners are rotated here with the same exact trig as the shader
+    Vertex* v = APP.Renderer.Vertices + APP.Renderer.VerticesCount;
+    WriteQuad(v, r, c, texId, uv);
+    float s = sinf(rotation), cs = cosf(rotation);
+    const float cornersX[4] = { -pivotX, r.w - pivotX, r.w - pivotX, -pivotX };
+    const float cornersY[4] = { -pivotY, -pivotY, r.h - pivotY, r.h - pivotY };
+    for(int i = 0; i < 4; i++)
+    {
+        v[i].Pos.x = r.x + pivotX + cs * cornersX[i] - s * cornersY[i];
+        v[i].Pos.y = r.y + pivotY + s * cornersX[i] + cs * cornersY[i];
+    }
+    APP.Renderer.VerticesCount += 4;
+}
+
+// Scales r around the origin and culls against the box any rotation of it fits in
+static bool TransformRectangle(RECTANGLE* r, TRANSFORM2D transform, float* pivotX, float* pivotY)
+{
+    *pivotX = transform.OriginX * transform.ScaleX;
+    *pivotY = transform.OriginY * transform.ScaleY;
+    r->x += transform.OriginX - *pivotX;
+    r->y += transform.OriginY - *pivotY;
+    r->w *= transform.ScaleX;
+    r->h *= transform.ScaleY;
+
+    const float x = r->x + *pivotX;
+    const float y = r->y + *pivotY;
+    const float extentX = fmaxf(fabsf(*pivotX), fabsf(r->w - *pivotX));
+    const float extentY = fmaxf(fabsf(*pivotY), fabsf(r->h - *pivotY));
+    const float reach = extentX + extentY;
+    return CullRectangle((RECTANGLE){ x - reach, y - reach, 2.0f * reach, 2.0f * reach });
+}
+
+void DrawRectanglePro(RECTANGLE r, TRANSFORM2D transform, COLOR c)
+{
+    float pivotX, pivotY;
+    if(TransformRectangle(&r, transform, &pivotX, &pivotY)) return;
+    PushRotatedQuad(r, pivotX, pivotY, transform.Rotation, c, -1, FULL_UV);
+}
+
+void DrawRectangleTexPro(RECTANGLE r, TEXTURE2D t, RECTANGLE uv, TRANSFORM2D transform)
+{
+    float pivotX, pivotY;
+    if(TransformRectangle(&r, transform, &pivotX, &pivotY)) return;
+    if(BatchIsFull()) FlushBatch();
+    PushRotatedQuad(r, pivotX, pivotY, transform.Rotation, WHITE, GetTextureSlot(t), uv);
+}
+
+// Writes as many quads as the current batch has room for and returns how many that was
+static int PushQuads(const RECTANGLE* rects, const COLOR* colors, int colorStride, int texId, int count)
+{
+    if(APP.Renderer.Mode == BATCH_MODE_INSTANCED)
+    {
+        int room = MAXIMUM_QUADS - APP.Renderer.InstancesCount;
+        if(count > room) count = room;
+        Instance* instances = APP.Renderer.Instances + APP.Renderer.InstancesCount;
+        for(int i = 0; i < count; i++, colors += colorStride)
+            instances[i] = (Instance){ rects[i], *colors, { 0, 0, UINT16_MAX, UINT16_MAX }, texId, { 0.0f, 0.0f }, 0.0f, 0 };
+        APP.Renderer.InstancesCount += count;
+        return count;
+    }
+    int room = (MAXIMUM_VERTICES - APP.Renderer.VerticesCount) / 4;
+    if(count > room) count = room;
+    APP.Renderer.ExpandQuads(APP.Renderer.Vertices + APP.Renderer.VerticesCount, rects, colors, colorStride, texId, count);
+    APP.Renderer.VerticesCount += count * 4;
+    return count;
+}
+
+// Skips the culled rectangles at the front and returns how many visible ones follow them
+static int NextVisibleRun(const RECTANGLE* rects, int count, int* skipped)
+{
+    int first = 0;
+    while(first < count && IsCulled(rects[first])) first++;
+    int last = first;
+    while(last < count && !IsCulled(rects[last])) last++;
+    APP.Renderer.Stats.Culled += first;
+    *skipped = first;
+    return last - first;
+}
+
+void DrawRectangles(const RECTANGLE* rects, const COLOR* colors, int count)
+{
+    while(count > 0)
+    {
+        int skipped;
+        int run = NextVisibleRun(rects, count, &skipped);
+        rects += skipped;
+        colors += skipped;
+        count -= skipped + run;
+        while(run > 0)
+        {
+            if(BatchIsFull()) FlushBatch();
+            int pushed = PushQuads(rects, colors, 1, -1, run);
+            rects += pushed;
+            colors += pushed;
+            run -= pushed;
+        }
+    }
+}
+
+void DrawRectanglesTex(const RECTANGLE* rects, int count, TEXTURE2D t)
+{
+    while(count > 0)
+    {
+        int skipped;
+        int run = NextVisibleRun(rects, count, &skipped);
+        rects += skipped;
+        count -= skipped + run;
+        while(run > 0)
+        {
+            if(BatchIsFull()) FlushBatch();
+            int pushed = PushQuads(rects, &WHITE, 0, GetTextureSlot(t), run);
+            rects += pushed;
+            run -= pushed;
+        }
+    }
+}
+
+// Pending quads address arrays by slot, so they're drawn before the slots are handed out again
+static void ReleaseTextureArraySlots()
+{
+    if(APP.Renderer.Drawing && APP.Renderer.NextAvailArraySlot > 0) FlushBatch();
+    APP.Renderer.NextAvailArraySlot = 0;
+}
+
+static bool IsTextureArrayResident(const TEXTURE_ARRAY* array)
+{
+    for(int slot = 0; slot < APP.Renderer.NextAvailArraySlot; slot++)
+    {
+        if(APP.Renderer.TextureArrays[slot] == array) return true;
+    }
+    return false;
+}
+
+// Same as GetTextureSlot, but array slots are only rebound when every slot holds another array
+static int GetTextureArraySlot(TEXTURE_ARRAY* array)
+{
+    for(int slot = 0; slot < APP.Renderer.NextAvailArraySlot; slot++)
+    {
+        if(APP.Renderer.TextureArrays[slot] == array) return slot;
+    }
+    if(APP.Renderer.NextAvailArraySlot >= MAXIMUM_TEXTURE_ARRAY_SLOT)
+    {
+        FlushBatch();
+        APP.Renderer.NextAvailArraySlot = 0;
+    }
+
+    int slot = APP.Renderer.NextAvailArraySlot++;
+    APP.Renderer.TextureArrays[slot] = array;
+    hxglEnableTextureArray(array->Handle, APP.Renderer.TextureSlots + slot);
+    if(array->MipmapsDirty)
+    {
+        hxglGenerateTextureArrayMipmaps(array->Handle);
+        array->MipmapsDirty = false;
+    }
+    APP.Renderer.Stats.TextureBinds += 1;
+    return slot;
+}
+
+void DrawRectangleLayer(RECTANGLE r, TEXTURE_LAYER t)
+{
+    if(CullRectangle(r)) return;
+    if(BatchIsFull()) FlushBatch();
+    PushQuad(r, WHITE, TEXTURE_ARRAY_ID(GetTextureArraySlot(t.Array), t.Layer), FULL_UV);
+}
+
+IMAGE* LoadImage(const void* data, int width, int height)
+{
+    IMAGE* img = malloc(sizeof(IMAGE));
+    img->Width = width;
+    img->Height = height;
+    img->Data = (void*) data;
+    img->LoadedFromFile = false;
+    return img;
+}
+
+IMAGE* LoadImageFromFile(const char* path, bool flip)
+{
+    stbi_set_flip_vertically_on_load(flip);
+    int w, h;
+    uint8_t* data = stbi_load(path, &w, &h, NULL, 4);
+    IMAGE* img = LoadImage((void*)data, w, h);
+    img->LoadedFromFile = true;
+    return img;
+}
+
+RECTANGLE GetImageShape(const IMAGE* img)
+{
+    RECTANGLE r = {0};
+    r.w = (float) img->Width;
+    r.h = (float) img->Height;
+    r.x = 0.0f;
+    r.y = 0.0f;
+    return r;
+}
+
+void DestroyImage(IMAGE* image)
+{
+    stbi_image_free(image->Data);
+    free(image);
+    image = NULL;
+}
+
+TEXTURE2D LoadTextureFromImage(const IMAGE* image)
+{
+    TEXTURE2D tex = hxglLoadTexture(image->Data, image->Width, image->Height, HXGL_LINEAR_MIPMAP_LINEAR);
+    return tex;
+}
+
+TEXTURE_ARRAY* LoadTextureArray(int width, int height, int layers)
+{
+    TEXTURE_ARRAY* array = malloc(sizeof(TEXTURE_ARRAY));
+    array->Handle = hxglLoadTextureArray(width, height, layers, HXGL_LINEAR_MIPMAP_LINEAR);
+    array->Width = width;
+    array->Height = height;
+    array->Layers = layers;
+    array->UsedLayers = 0;
+    array->MipmapsDirty = false;
+    return array;
+}
+
+TEXTURE_LAYER LoadTextureLayerFromImage(TEXTURE_ARRAY* array, const IMAGE* image)
+{
+    TEXTURE_LAYER layer = { array, -1 };
+    if(image->Width != array->Width || image->Height != array->Height) return layer;
+    if(array->UsedLayers >= array->Layers) return layer;
+    // Quads already batched from this array must not see the new layer, and the rebind rebuilds the mip chain
+    if(IsTextureArrayResident(array)) ReleaseTextureArraySlots();
+    layer.Layer = array->UsedLayers++;
+    hxglUpdateTextureArrayLayer(array->Handle, layer.Layer, image->Data, image->Width, image->Height);
+    array->MipmapsDirty = true;
+    return layer;
+}
+
+void DestroyTextureArray(TEXTURE_ARRAY* array)
+{
+    if(IsTextureArrayResident(array)) ReleaseTextureArraySlots();
+    hxglDropTexture(array->Handle);
+    free(array);
+}
+
+/** Static Layers */
+STATIC_LAYER* LoadStaticLayer(int capacity)
+{
+    // The shared index buffer covers MAXIMUM_QUADS, larger maps are split into several layers
+    if(capacity < 1 || capacity > MAXIMUM_QUADS) capacity = MAXIMUM_QUADS;
+    STATIC_LAYER* layer = calloc(1, sizeof(STATIC_LAYER));
+    layer->Vertices = malloc((size_t)capacity * 4 * sizeof(Vertex));
+    layer->Capacity = capacity;
+    layer->DirtyFirst = capacity;
+    layer->DirtyLast = -1;
+
+    layer->VAO = hxglLoadVertexArray();
+    hxglEnableVertexArray(layer->VAO);
+    layer->VBO = hxglLoadVertexBuffer(NULL, capacity * 4 * sizeof(Vertex), false);
+    SetVertexLayout();
+    hxglEnableIndexBuffer(APP.Renderer.IBO);
+    hxglDisableVertexArray();
+    return layer;
+}
+
+static int GetStaticLayerSlot(STATIC_LAYER* layer, TEXTURE2D t)
+{
+    for(int slot = 0; slot < layer->TexturesCount; slot++)
+    {
+        if(layer->Textures[slot] == t) return slot;
+    }
+    if(layer->TexturesCount >= APP.Renderer.TextureSlots) return -1;
+    layer->Textures[layer->TexturesCount] = t;
+    return layer->TexturesCount++;
+}
+
+static void WriteStaticQuad(STATIC_LAYER* layer, int index, RECTANGLE r, COLOR c, int texId, RECTANGLE uv)
+{
+    WriteQuad(layer->Vertices + index * 4, r, c, texId, uv);
+    if(index < layer->DirtyFirst) layer->DirtyFirst = index;
+    if(index > layer->DirtyLast) layer->DirtyLast = index;
+}
+
+// Returns the index to update the rectangle with, -1 when the layer is full
+int AddStaticRectangle(STATIC_LAYER* layer, RECTANGLE r, COLOR c)
+{
+    if(layer->QuadsCount >= layer->Capacity) return -1;
+    WriteStaticQuad(layer, layer->QuadsCount, r, c, -1, FULL_UV);
+    return layer->QuadsCount++;
+}
+
+// Also -1 when the layer already uses as many textures as there are texture slots
+int AddStaticRectangleTex(STATIC_LAYER* layer, RECTANGLE r, TEXTURE2D t, RECTANGLE uv)
+{
+    if(layer->QuadsCount >= layer->Capacity) return -1;
+    int slot = GetStaticLayerSlot(layer, t);
+    if(slot < 0) return -1;
+    WriteStaticQuad(layer, layer->QuadsCount, r, WHITE, slot, uv);
+    return layer->QuadsCount++;
+}
+
+void SetStaticRectangle(STATIC_LAYER* layer, int index, RECTANGLE r, COLOR c)
+{
+    if(index < 0 || index >= layer->QuadsCount) return;
+    WriteStaticQuad(layer, index, r, c, -1, FULL_UV);
+}
+
+bool SetStaticRectangleTex(STATIC_LAYER* layer, int index, RECTANGLE r, TEXTURE2D t, RECTANGLE uv)
+{
+    if(index < 0 || index >= layer->QuadsCount) return false;
+    int slot = GetStaticLayerSlot(layer, t);
+    if(slot < 0) return false;
+    WriteStaticQuad(layer, index, r, WHITE, slot, uv);
+    return true;
+}
+
+void DrawStaticLayer(STATIC_LAYER* layer)
+{
+    if(!APP.Renderer.Drawing || layer->QuadsCount == 0) return;
+    // Whatever was batched before the layer has to be drawn under it
+    SubmitBatch();
+
+    // Only the changed span is sent, the rest of the buffer stays where it is on the GPU
+    if(layer->DirtyFirst <= layer->DirtyLast)
+    {
+        double transfer = ProfileNow();
+        int quads = layer->DirtyLast - layer->DirtyFirst + 1;
+        hxglUpdateVertexBuffer(layer->VBO, layer->Vertices + layer->DirtyFirst * 4, quads * 4 * sizeof(Vertex), layer->DirtyFirst * 4 * sizeof(Vertex));
+        EndProfileZone(PROFILE_TRANSFER, transfer);
+        layer->DirtyFirst = layer->Capacity;
+        layer->DirtyLast = -1;
+    }
+
+    for(int slot = 0; slot < layer->TexturesCount; slot++) hxglEnableTexture(layer->Textures[slot], slot);
+    hxglEnableShader(APP.Renderer.Shader);
+    hxglEnableVertexArray(layer->VAO);
+    BeginGpuZone();
+    hxglDrawVertexArrayElementsBaseVertex(0, layer->QuadsCount * 6, ELEMENT_KIND, 0);
+    EndGpuZone();
+    APP.Renderer.Stats.DrawCalls += 1;
+    APP.Renderer.Stats.Quads += layer->QuadsCount;
+    APP.Renderer.Stats.Vertices += layer->QuadsCount * 4;
+    APP.Renderer.Stats.TextureBinds += layer->TexturesCount;
+
+    // The layer took over the first texture slots, the next batch starts binding from scratch
+    BeginBatch();
+}
+
+void DestroyStaticLayer(STATIC_LAYER* layer)
+{
+    hxglDropVertexArray(layer->VAO);
+    hxglDropVertexBuffer(layer->VBO);
+    free(layer->Vertices);
+    free(layer);
+}
+
+/** Sprite Sheets */
+// Reallocates the GPU copy as well, so the table grows geometrically and the rows are sent again only then
+static bool GrowFrameTable(int rows)
+{
+    int capacity = APP.Frames.Capacity ? APP.Frames.Capacity : 256;
+    while(capacity < rows) capacity *= 2;
+    float (*grown)[4] = realloc(APP.Frames.Rows, (size_t)capacity * sizeof(APP.Frames.Rows[0]));
+    if(grown == NULL) return false;
+    APP.Frames.Rows = grown;
+    APP.Frames.Capacity = capacity;
+
+    if(APP.Frames.Texture) hxglDropTextureBuffer(APP.Frames.Texture, APP.Frames.Buffer);
+    APP.Frames.Texture = hxglLoadTextureBuffer(capacity * (int)sizeof(APP.Frames.Rows[0]), &APP.Frames.Buffer);
+    if(APP.Frames.Count > 0) hxglUpdateTextureBuffer(APP.Frames.Buffer, APP.Frames.Rows, APP.Frames.Count * (int)sizeof(APP.Frames.Rows[0]), 0);
+    hxglEnableTextureBuffer(APP.Frames.Texture, APP.Frames.Unit);
+    return true;
+}
+
+// First fit among the rows of destroyed sheets, otherwise appended, -1 when the table can't grow
+static int AllocateFrameRows(int count)
+{
+    for(int i = 0; i < APP.Frames.FreeCount; i++)
+    {
+        FrameRange* range = &APP.Frames.Free[i];
+        if(range->Count < count) continue;
+        int first = range->First;
+        range->First += count;
+        range->Count -= count;
+        if(range->Count == 0)
+        {
+            memmove(range, range + 1, sizeof(FrameRange) * (APP.Frames.FreeCount - i - 1));
+            APP.Frames.FreeCount--;
+        }
+        return first;
+    }
+    if(APP.Frames.Count + count > APP.Frames.Capacity && !GrowFrameTable(APP.Frames.Count + count)) return -1;
+    int first = APP.Frames.Count;
+    APP.Frames.Count += count;
+    return first;
+}
+
+static void FreeFrameRows(int first, int count)
+{
+    int i = 0;
+    while(i < APP.Frames.FreeCount && APP.Frames.Free[i].First < first) i++;
+    bool mergePrevious = i > 0 && APP.Frames.Free[i - 1].First + APP.Frames.Free[i - 1].Count == first;
+    bool mergeNext = i < APP.Frames.FreeCount && first + count == APP.Frames.Free[i].First;
+    if(mergePrevious && mergeNext)
+    {
+        APP.Frames.Free[i - 1].Count += count + APP.Frames.Free[i].Count;
+        memmove(&APP.Frames.Free[i], &APP.Frames.Free[i + 1], sizeof(FrameRange) * (APP.Frames.FreeCount - i - 1));
+        APP.Frames.FreeCount--;
+        i--;
+    }
+    else if(mergePrevious)
+    {
+        APP.Frames.Free[--i].Count += count;
+    }
+    else if(mergeNext)
+    {
+        APP.Frames.Free[i].First = first;
+        APP.Frames.Free[i].Count += count;
+    }
+    else
+    {
+        if(APP.Frames.FreeCount == APP.Frames.FreeCapacity)
+        {
+            int capacity = APP.Frames.FreeCapacity ? APP.Frames.FreeCapacity * 2 : 16;
+            FrameRange* grown = realloc(APP.Frames.Free, capacity * sizeof(FrameRange));
+            if(grown == NULL) return; // The rows stay taken
+            APP.Frames.Free = grown;
+            APP.Frames.FreeCapacity = capacity;
+        }
+        memmove(&APP.Frames.Free[i + 1], &APP.Frames.Free[i], sizeof(FrameRange) * (APP.Frames.FreeCount - i));
+        APP.Frames.Free[i] = (FrameRange){ first, count };
+        APP.Frames.FreeCount++;
+    }
+    // A range that reaches the end of the table shortens it instead
+    FrameRange* range = &APP.Frames.Free[i];
+    if(range->First + range->Count == APP.Frames.Count)
+    {
+        APP.Frames.Count = range->First;
+        APP.Frames.FreeCount--;
+    }
+}
+
+// Only the sheet's own rows are uploaded, sheets are loaded rarely
+SPRITE_SHEET* LoadSpriteSheet(TEXTURE2D t, const RECTANGLE* frames, int count)
+{
+    if(count < 1) return NULL;
+    SPRITE_SHEET* sheet = calloc(1, sizeof(SPRITE_SHEET));
+    if(sheet == NULL) return NULL;
+    sheet->FirstRow = AllocateFrameRows(count);
+    if(sheet->FirstRow < 0)
+    {
+        free(sheet);
+        return NULL;
+    }
+    sheet->Texture = t;
+    sheet->FramesCount = count;
+    for(int i = 0; i < count; i++)
+    {
+        float* row = APP.Frames.Rows[sheet->FirstRow + i];
+        row[0] = frames[i].x;
+        row[1] = frames[i].y;
+        row[2] = frames[i].x + frames[i].w;
+        row[3] = frames[i].y + frames[i].h;
+    }
+    int rowSize = (int)sizeof(APP.Frames.Rows[0]);
+    hxglUpdateTextureBuffer(APP.Frames.Buffer, APP.Frames.Rows[sheet->FirstRow], count * rowSize, sheet->FirstRow * rowSize);
+    return sheet;
+}
+
+// Frames numbered left to right, top to bottom
+SPRITE_SHEET* LoadSpriteSheetGrid(TEXTURE2D t, int columns, int rows)
+{
+    if(columns < 1 || rows < 1) return NULL;
+    RECTANGLE* frames = malloc((size_t)columns * rows * sizeof(RECTANGLE));
+    if(frames == NULL) return NULL;
+    for(int y = 0; y < rows; y++)
+    {
+        for(int x = 0; x < columns; x++)
+            frames[y * columns + x] = (RECTANGLE){ (float)x / columns, (float)y / rows, 1.0f / columns, 1.0f / rows };
+    }
+    SPRITE_SHEET* sheet = LoadSpriteSheet(t, frames, columns * rows);
+    free(frames);
+    return sheet;
+}
+
+// Returns the animation to play instances with, -1 when the frames are outside the sheet
+int AddSpriteAnimation(SPRITE_SHEET* sheet, int firstFrame, int framesCount, float framesPerSecond, bool loop)
+{
+    if(firstFrame < 0 || framesCount < 1 || firstFrame + framesCount > sheet->FramesCount) return -1;
+    if(sheet->AnimationsCount == sheet->AnimationsCapacity)
+    {
+        int capacity = sheet->AnimationsCapacity ? sheet->AnimationsCapacity * 2 : 8;
+        SpriteAnimation* grown = realloc(sheet->Animations, capacity * sizeof(SpriteAnimation));
+        if(grown == NULL) return -1;
+        sheet->Animations = grown;
+        sheet->AnimationsCapacity = capacity;
+    }
+    sheet->Animations[sheet->AnimationsCount] = (SpriteAnimation){ firstFrame, framesCount, framesPerSecond > 0.0f ? framesPerSecond : 1.0f, loop };
+    return sheet->AnimationsCount++;
+}
+
+// row is 1 + frame table row, instanced batches leave the lookup to the shader
+static void PushFrameQuad(RECTANGLE r, int texId, int32_t row)
+{
+    if(APP.Renderer.Mode == BATCH_MODE_INSTANCED)
+    {
+        Instance* instance = APP.Renderer.Instances + APP.Renderer.InstancesCount++;
+        *instance = (Instance){ r, WHITE, { 0, 0, 0, 0 }, texId, { 0.0f, 0.0f }, 0.0f, row };
+        return;
+    }
+    const float* uv = APP.Frames.Rows[row - 1];
+    WriteQuad(APP.Renderer.Vertices + APP.Renderer.VerticesCount, r, WHITE, texId, (RECTANGLE){ uv[0], uv[1], uv[2] - uv[0], uv[3] - uv[1] });
+    APP.Renderer.VerticesCount += 4;
+}
+
+void DrawSpriteFrame(RECTANGLE r, const SPRITE_SHEET* sheet, int frame)
+{
+    if(frame < 0 || frame >= sheet->FramesCount) return;
+    if(CullRectangle(r)) return;
+    if(BatchIsFull()) FlushBatch();
+    PushFrameQuad(r, GetTextureSlot(sheet->Texture), sheet->FirstRow + frame + 1);
+}
+
+// The rows go back to the table for the next sheet, animators of the sheet mustn't be drawn afterwards
+void DestroySpriteSheet(SPRITE_SHEET* sheet)
+{
+    if(sheet == NULL) return;
+    FreeFrameRows(sheet->FirstRow, sheet->FramesCount);
+    free(sheet->Animations);
+    free(sheet);
+}
+
+ANIMATOR* LoadAnimator(SPRITE_SHEET* sheet, int capacity)
+{
+    if(capacity < 1) capacity = 64;
+    ANIMATOR* animator = calloc(1, sizeof(ANIMATOR));
+    if(animator == NULL) return NULL;
+    animator->Sheet = sheet;
+    animator->Capacity = capacity;
+    animator->Animation = malloc(capacity * sizeof(int));
+    animator->Time = malloc(capacity * sizeof(float));
+    animator->Frame = malloc(capacity * sizeof(int32_t));
+    if(animator->Animation == NULL || animator->Time == NULL || animator->Frame == NULL)
+    {
+        DestroyAnimator(animator);
+        return NULL;
+    }
+    return animator;
+}
+
+static int32_t AnimationRow(const SPRITE_SHEET* sheet, const SpriteAnimation* animation, float time)
+{
+    int frame = (int)(time * animation->FramesPerSecond);
+    if(frame >= animation->FramesCount) frame = animation->Loop ? frame % animation->FramesCount : animation->FramesCount - 1;
+    return sheet->FirstRow + animation->FirstFrame + frame + 1;
+}
+
+// Returns the instance, which is also the index of its rectangle in DrawAnimator
+int AddAnimationInstance(ANIMATOR* animator, int animation)
+{
+    if(animation < 0 || animation >= animator->Sheet->AnimationsCount) return -1;
+    if(animator->Count == animator->Capacity)
+    {
+        // Each array keeps the old capacity until all three have grown
+        int capacity = animator->Capacity * 2;
+        int* animation = realloc(animator->Animation, capacity * sizeof(int));
+        if(animation == NULL) return -1;
+        animator->Animation = animation;
+        float* time = realloc(animator->Time, capacity * sizeof(float));
+        if(time == NULL) return -1;
+        animator->Time = time;
+        int32_t* frame = realloc(animator->Frame, capacity * sizeof(int32_t));
+        if(frame == NULL) return -1;
+        animator->Frame = frame;
+        animator->Capacity = capacity;
+    }
+    int instance = animator->Count++;
+    PlayAnimation(animator, instance, animation);
+    return instance;
+}
+
+// Restarts the instance on the animation
+void PlayAnimation(ANIMATOR* animator, int instance, int animation)
+{
+    if(instance < 0 || instance >= animator->Count) return;
+    if(animation < 0 || animation >= animator->Sheet->AnimationsCount) return;
+    animator->Animation[instance] = animation;
+    animator->Time[instance] = 0.0f;
+    animator->Frame[instance] = AnimationRow(animator->Sheet, &animator->Sheet->Animations[animation], 0.0f);
+}
+
+void UpdateAnimator(ANIMATOR* animator, float dt)
+{
+    const SPRITE_SHEET* sheet = animator->Sheet;
+    for(int i = 0; i < animator->Count; i++)
+    {
+        const SpriteAnimation* animation = &sheet->Animations[animator->Animation[i]];
+        float time = animator->Time[i] + dt;
+        // Wrapped so the time never grows large enough to lose precision
+        float duration = animation->FramesCount / animation->FramesPerSecond;
+        if(animation->Loop && time >= duration) time = fmodf(time, duration);
+        animator->Time[i] = time;
+        animator->Frame[i] = AnimationRow(sheet, animation, time);
+    }
+}
+
+// Frame of the sheet the instance shows, -1 for an unknown instance
+int GetAnimationFrame(const ANIMATOR* animator, int instance)
+{
+    if(instance < 0 || instance >= animator->Count) return -1;
+    return animator->Frame[instance] - 1 - animator->Sheet->FirstRow;
+}
+
+// Draws instance i at rects[i]
+void DrawAnimator(const ANIMATOR* animator, const RECTANGLE* rects)
+{
+    int texId = -1;
+    for(int i = 0; i < animator->Count; i++)
+    {
+        if(CullRectangle(rects[i])) continue;
+        // Flushing resets the slots, the texture has to be looked up again afterwards
+        if(BatchIsFull())
+        {
+            FlushBatch();
+            texId = -1;
+        }
+        if(texId < 0) texId = GetTextureSlot(animator->Sheet->Texture);
+        PushFrameQuad(rects[i], texId, animator->Frame[i]);
+    }
+}
+
+void DestroyAnimator(ANIMATOR* animator)
+{
+    if(animator == NULL) return;
+    free(animator->Animation);
+    free(animator->Time);
+    free(animator->Frame);
+    free(animator);
+}
+
+/** Spatial Grid */
+SPATIAL_GRID* LoadSpatialGrid(float cellSize)
+{
+    SPATIAL_GRID* grid = calloc(1, sizeof(SPATIAL_GRID));
+    if(grid == NULL) return NULL;
+    grid->CellSize = cellSize > 0.0f ? cellSize : 256.0f;
+    grid->InvCellSize = 1.0f / grid->CellSize;
+    grid->CellsCapacity = 1024;
+    grid->Cells = calloc(grid->CellsCapacity, sizeof(GridCell));
+    if(grid->Cells == NULL)
+    {
+        free(grid);
+        return NULL;
+    }
+    return grid;
+}
+
+void DestroySpatialGrid(SPATIAL_GRID* grid)
+{
+    for(int i = 0; i < grid->CellsCapacity; i++) free(grid->Cells[i].Objects);
+    free(grid->Cells);
+    free(grid->Oversized.Objects);
+    free(grid->Objects);
+    free(grid->FreeObjects);
+    free(grid);
+}
+
+static uint32_t HashCell(int32_t x, int32_t y)
+{
+    return ((uint32_t)x * 73856093u) ^ ((uint32_t)y * 19349663u);
+}
+
+// Returns NULL for a cell that doesn't exist unless create is set, or when creating it runs out of memory
+static GridCell* FindGridCell(SPATIAL_GRID* grid, int32_t x, int32_t y, bool create)
+{
+    // Keep the table at most half full so probes stay short, a failed grow just lets it fill up further
+    GridCell* cells = create && (grid->CellsUsed + 1) * 2 > grid->CellsCapacity ? calloc(grid->CellsCapacity * 2, sizeof(GridCell)) : NULL;
+    if(cells)
+    {
+        GridCell* old = grid->Cells;
+        int oldCapacity = grid->CellsCapacity;
+        grid->Cells = cells;
+        grid->CellsCapacity *= 2;
+        for(int i = 0; i < oldCapacity; i++)
+        {
+            if(!old[i].Used) continue;
+            uint32_t mask = grid->CellsCapacity - 1;
+            uint32_t slot = HashCell(old[i].X, old[i].Y) & mask;
+            while(grid->Cells[slot].Used) slot = (slot + 1) & mask;
+            grid->Cells[slot] = old[i];
+        }
+        free(old);
+    }
+
+    uint32_t mask = grid->CellsCapacity - 1;
+    uint32_t slot = HashCell(x, y) & mask;
+    while(grid->Cells[slot].Used)
+    {
+        if(grid->Cells[slot].X == x && grid->Cells[slot].Y == y) return &grid->Cells[slot];
+        slot = (slot + 1) & mask;
+    }
+    if(!create || grid->CellsUsed + 1 >= grid->CellsCapacity) return NULL;
+    grid->Cells[slot] = (GridCell){ x, y, true, NULL, 0, 0 };
+    grid->CellsUsed += 1;
+    return &grid->Cells[slot];
+}
+
+// Emptied cells are dropped so objects moving through the world don't grow the table without bound
+static void DropGridCell(SPATIAL_GRID* grid, GridCell* cell)
+{
+    uint32_t mask = grid->CellsCapacity - 1;
+    uint32_t hole = (uint32_t)(cell - grid->Cells);
+    free(cell->Objects);
+    grid->Cells[hole] = (GridCell){0};
+    grid->CellsUsed -= 1;
+    // Cells further along the probe run move back into the hole, lookups stop at the first unused slot
+    for(uint32_t slot = (hole + 1) & mask; grid->Cells[slot].Used; slot = (slot + 1) & mask)
+    {
+        uint32_t home = HashCell(grid->Cells[slot].X, grid->Cells[slot].Y) & mask;
+        if(((slot - home) & mask) < ((slot - hole) & mask)) continue;
+        grid->Cells[hole] = grid->Cells[slot];
+        grid->Cells[slot] = (GridCell){0};
+        hole = slot;
+    }
+}
+
+static bool GridCellAdd(GridCell* cell, int handle)
+{
+    if(cell->Count == cell->Capacity)
+    {
+        int capacity = cell->Capacity ? cell->Capacity * 2 : 4;
+        int* objects = realloc(cell->Objects, capacity * sizeof(int));
+        if(objects == NULL) return false;
+        cell->Objects = objects;
+        cell->Capacity = capacity;
+    }
+    cell->Objects[cell->Count++] = handle;
+    return true;
+}
+
+static void GridCellRemove(GridCell* cell, int handle)
+{
+    for(int i = 0; i < cell->Count; i++)
+    {
+        if(cell->Objects[i] != handle) continue;
+        cell->Objects[i] = cell->Objects[--cell->Count];
+        return;
+    }
+}
+
+// Far away or NaN coordinates are clamped, converting them to int as they are is undefined
+static int GridCoord(const SPATIAL_GRID* grid, float x)
+{
+    float cell = floorf(x * grid->InvCellSize);
+    if(!(cell > (float)-GRID_MAXIMUM_COORD)) return -GRID_MAXIMUM_COORD;
+    if(cell > (float)GRID_MAXIMUM_COORD) return GRID_MAXIMUM_COORD;
+    return (int)cell;
+}
+
+static int64_t GridSpan(int minX, int minY, int maxX, int maxY)
+{
+    return ((int64_t)maxX - minX + 1) * ((int64_t)maxY - minY + 1);
+}
+
+// Takes the handle out of the first count cells of the box, row by row, in the order they were linked
+static void UnlinkGridCells(SPATIAL_GRID* grid, int handle, int minX, int minY, int maxX, int maxY, int64_t count)
+{
+    for(int y = minY; y <= maxY && count > 0; y++)
+    {
+        for(int x = minX; x <= maxX && count > 0; x++, count--)
+        {
+            GridCell* cell = FindGridCell(grid, x, y, false);
+            if(cell == NULL) continue;
+            GridCellRemove(cell, handle);
+            if(cell->Count == 0) DropGridCell(grid, cell);
+        }
+    }
+}
+
+// An object whose cells run out of memory goes to the oversized list instead, false when even that fails
+static bool LinkGridObject(SPATIAL_GRID* grid, int handle)
+{
+    GridObject* object = &grid->Objects[handle];
+    RECTANGLE r = object->Bounds;
+    int minX = GridCoord(grid, r.x), minY = GridCoord(grid, r.y);
+    int maxX = GridCoord(grid, r.x + r.w), maxY = GridCoord(grid, r.y + r.h);
+    object->MinX = 1;
+    object->MaxX = 0;
+    int64_t span = GridSpan(minX, minY, maxX, maxY);
+    if(span <= GRID_MAXIMUM_SPAN)
+    {
+        int64_t linked = 0;
+        for(int y = minY; y <= maxY && linked >= 0; y++)
+        {
+            for(int x = minX; x <= maxX; x++)
+            {
+                GridCell* cell = FindGridCell(grid, x, y, true);
+                if(cell == NULL || !GridCellAdd(cell, handle))
+                {
+                    // The cell may have just been created empty
+                    if(cell && cell->Count == 0) DropGridCell(grid, cell);
+                    UnlinkGridCells(grid, handle, minX, minY, maxX, maxY, linked);
+                    linked = -1;
+                    break;
+                }
+                linked++;
+            }
+        }
+        if(linked == span)
+        {
+            object->MinX = minX;
+            object->MinY = minY;
+            object->MaxX = maxX;
+            object->MaxY = maxY;
+            return true;
+        }
+    }
+    return GridCellAdd(&grid->Oversized, handle);
+}
+
+static void UnlinkGridObject(SPATIAL_GRID* grid, int handle)
+{
+    GridObject* object = &grid->Objects[handle];
+    if(object->MinX > object->MaxX) GridCellRemove(&grid->Oversized, handle);
+    else UnlinkGridCells(grid, handle, object->MinX, object->MinY, object->MaxX, object->MaxY, GridSpan(object->MinX, object->MinY, object->MaxX, object->MaxY));
+}
+
+static bool IsGridHandle(const SPATIAL_GRID* grid, int handle)
+{
+    return handle >= 0 && handle < grid->ObjectsCount && grid->Objects[handle].Alive;
+}
+
+// Returns a handle for moving or removing the object, userId is what queries report, -1 when out of memory
+int AddGridObject(SPATIAL_GRID* grid, RECTANGLE bounds, int userId)
+{
+    int handle;
+    if(grid->FreeCount > 0) handle = grid->FreeObjects[--grid->FreeCount];
+    else
+    {
+        if(grid->ObjectsCount == grid->ObjectsCapacity)
+        {
+            int capacity = grid->ObjectsCapacity ? grid->ObjectsCapacity * 2 : 256;
+            GridObject* objects = realloc(grid->Objects, capacity * sizeof(GridObject));
+            if(objects == NULL) return -1;
+            grid->Objects = objects;
+            grid->ObjectsCapacity = capacity;
+        }
+        handle = grid->ObjectsCount++;
+    }
+    grid->Objects[handle] = (GridObject){ bounds, userId, 0, 0, 0, 0, 0, true };
+    if(!LinkGridObject(grid, handle))
+    {
+        grid->Objects[handle].Alive = false;
+        // The last handle is given back by shrinking, any other was popped from the free list, which still has its slot
+        if(handle == grid->ObjectsCount - 1) grid->ObjectsCount--;
+        else grid->FreeObjects[grid->FreeCount++] = handle;
+        return -1;
+    }
+    return handle;
+}
+
+// Only touches the cells when the object crosses a cell border, an object that can't be relinked isn't found until it's moved again
+void MoveGridObject(SPATIAL_GRID* grid, int handle, RECTANGLE bounds)
+{
+    if(!IsGridHandle(grid, handle)) return;
+    GridObject* object = &grid->Objects[handle];
+    int minX = GridCoord(grid, bounds.x), minY = GridCoord(grid, bounds.y);
+    int maxX = GridCoord(grid, bounds.x + bounds.w), maxY = GridCoord(grid, bounds.y + bounds.h);
+    if(object->MinX <= object->MaxX && minX == object->MinX && minY == object->MinY && maxX == object->MaxX && maxY == object->MaxY)
+    {
+        object->Bounds = bounds;
+        return;
+    }
+    UnlinkGridObject(grid, handle);
+    object->Bounds = bounds;
+    LinkGridObject(grid, handle);
+}
+
+// Stale handles, including ones already removed, are ignored
+void RemoveGridObject(SPATIAL_GRID* grid, int handle)
+{
+    if(!IsGridHandle(grid, handle)) return;
+    UnlinkGridObject(grid, handle);
+    grid->Objects[handle].Alive = false;
+    if(grid->FreeCount == grid->FreeCapacity)
+    {
+        int capacity = grid->FreeCapacity ? grid->FreeCapacity * 2 : 64;
+        int* handles = realloc(grid->FreeObjects, capacity * sizeof(int));
+        if(handles == NULL) return; // The handle just isn't reused
+        grid->FreeObjects = handles;
+        grid->FreeCapacity = capacity;
+    }
+    grid->FreeObjects[grid->FreeCount++] = handle;
+}
+
+static int QueryGridCell(SPATIAL_GRID* grid, const GridCell* cell, RECTANGLE area, int* results, int count, int maxResults)
+{
+    for(int i = 0; i < cell->Count && count < maxResults; i++)
+    {
+        GridObject* object = &grid->Objects[cell->Objects[i]];
+        if(object->Stamp == grid->Stamp) continue;
+        object->Stamp = grid->Stamp;
+        RECTANGLE r = object->Bounds;
+        if(r.x > area.x + area.w || r.y > area.y + area.h || r.x + r.w < area.x || r.y + r.h < area.y) continue;
+        results[count++] = object->UserId;
+    }
+    return count;
+}
+
+// Writes the user ids of the objects overlapping area, at most maxResults of them, and returns how many
+int QueryGrid(SPATIAL_GRID* grid, RECTANGLE area, int* results, int maxResults)
+{
+    if(++grid->Stamp == 0)
+    {
+        // The stamp wrapped, old stamps could collide with the new ones
+        for(int i = 0; i < grid->ObjectsCount; i++) grid->Objects[i].Stamp = 0;
+        grid->Stamp = 1;
+    }
+    int count = QueryGridCell(grid, &grid->Oversized, area, results, 0, maxResults);
+
+    int minX = GridCoord(grid, area.x), minY = GridCoord(grid, area.y);
+    int maxX = GridCoord(grid, area.x + area.w), maxY = GridCoord(grid, area.y + area.h);
+    // A sparse world seen from far away has fewer cells than the area covers
+    if(GridSpan(minX, minY, maxX, maxY) > grid->CellsUsed)
+    {
+        for(int i = 0; i < grid->CellsCapacity && count < maxResults; i++)
+        {
+            const GridCell* cell = &grid->Cells[i];
+            if(!cell->Used || cell->X < minX || cell->X > maxX || cell->Y < minY || cell->Y > maxY) continue;
+            count = QueryGridCell(grid, cell, area, results, count, maxResults);
+        }
+        return count;
+    }
+    for(int y = minY; y <= maxY; y++)
+    {
+        for(int x = minX; x <= maxX && count < maxResults; x++)
+        {
+            const GridCell* cell = FindGridCell(grid, x, y, false);
+            if(cell) count = QueryGridCell(grid, cell, area, results, count, maxResults);
+        }
+    }
+    return count;
+}
+
+/** Command Buffers */
+COMMAND_BUFFER* LoadCommandBuffer()
+{
+    COMMAND_BUFFER* buffer = calloc(1, sizeof(COMMAND_BUFFER));
+    MutexLock(&APP.Commands.Lock);
+    buffer->Id = APP.Commands.NextId++;
+    MutexUnlock(&APP.Commands.Lock);
+    return buffer;
+}
+
+void DestroyCommandBuffer(COMMAND_BUFFER* buffer)
+{
+    free(buffer->Commands);
+    free(buffer->Vertices);
+    free(buffer);
+}
+
+static void RecordCommand(COMMAND_BUFFER* buffer, RECTANGLE r, COLOR c, TEXTURE2D t, RECTANGLE uv, int layer, float depth)
+{
+    if(layer < INT16_MIN) layer = INT16_MIN;
+    if(layer > INT16_MAX) layer = INT16_MAX;
+    if(buffer->Count == buffer->Capacity)
+    {
+        // The command is dropped when either array can't grow
+        int capacity = buffer->Capacity ? buffer->Capacity * 2 : 1024;
+        DrawCommand* commands = realloc(buffer->Commands, capacity * sizeof(DrawCommand));
+        if(commands == NULL) return;
+        buffer->Commands = commands;
+        Vertex* vertices = realloc(buffer->Vertices, capacity * 4 * sizeof(Vertex));
+        if(vertices == NULL) return;
+        buffer->Vertices = vertices;
+        buffer->Capacity = capacity;
+    }
+    buffer->Commands[buffer->Count] = (DrawCommand){ r, uv, c, t, (int16_t)layer, (uint8_t)buffer->Blend, depth };
+    WriteQuad(buffer->Vertices + buffer->Count * 4, r, c, -1, uv);
+    buffer->Count += 1;
+}
+
+// Safe to call from any thread as long as each thread records into its own buffer
+void RecordRectangle(COMMAND_BUFFER* buffer, RECTANGLE r, COLOR c, int layer, float depth)
+{
+    RecordCommand(buffer, r, c, 0, FULL_UV, layer, depth);
+}
+
+void RecordRectangleTex(COMMAND_BUFFER* buffer, RECTANGLE r, TEXTURE2D t, RECTANGLE uv, int layer, float depth)
+{
+    RecordCommand(buffer, r, WHITE, t, uv, layer, depth);
+}
+
+void SetCommandBlendMode(COMMAND_BUFFER* buffer, BLEND_MODE mode)
+{
+    buffer->Blend = mode;
+}
+
+// The camera the whole buffer is drawn and culled through at EndDraw, NULL for screen space
+void SetCommandCamera(COMMAND_BUFFER* buffer, const CAMERA2D* camera)
+{
+    buffer->HasCamera = camera != NULL;
+    if(camera) buffer->Camera = *camera;
+}
+
+// Hands the buffer to the render thread, it's drawn and emptied by the next EndDraw and mustn't be touched until then
+void SubmitCommandBuffer(COMMAND_BUFFER* buffer)
+{
+    MutexLock(&APP.Commands.Lock);
+    // Submitting again before EndDraw is ignored, linking the buffer twice would loop the list
+    if(!buffer->Submitted)
+    {
+        buffer->Submitted = true;
+        buffer->NextSubmitted = APP.Commands.Submitted;
+        APP.Commands.Submitted = buffer;
+    }
+    MutexUnlock(&APP.Commands.Lock);
+}
+
+// Unsorted buffers are drawn in Id order and each one exactly in recording order, every blend change flushes
+void SetCommandSorting(bool enabled)
+{
+    APP.Commands.Sorting = enabled;
+}
+
+static bool SameCamera(const COMMAND_BUFFER* a, const COMMAND_BUFFER* b)
+{
+    if(a->HasCamera != b->HasCamera) return false;
+    return !a->HasCamera || memcmp(&a->Camera, &b->Camera, sizeof(CAMERA2D)) == 0;
+}
+
+static void DrawCommandQuad(const COMMAND_BUFFER* buffer, int index)
+{
+    const DrawCommand* command = &buffer->Commands[index];
+    // Culling needs the buffer's view, so the camera goes in place first
+    if(APP.Commands.Camera != buffer && (APP.Commands.Camera == NULL || !SameCamera(APP.Commands.Camera, buffer)))
+    {
+        if(buffer->HasCamera) BeginCamera(buffer->Camera);
+        else EndCamera();
+    }
+    APP.Commands.Camera = buffer;
+    if(CullRectangle(command->Rect)) return;
+    SetBlendMode((BLEND_MODE)command->Blend);
+    if(BatchIsFull()) FlushBatch();
+    int texId = command->Texture ? GetTextureSlot(command->Texture) : -1;
+    if(APP.Renderer.Mode == BATCH_MODE_INSTANCED)
+    {
+        PushQuad(command->Rect, command->Color, texId, command->Uv);
+        return;
+    }
+    Vertex* v = APP.Renderer.Vertices + APP.Renderer.VerticesCount;
+    memcpy(v, buffer->Vertices + index * 4, 4 * sizeof(Vertex));
+    if(texId >= 0)
+    {
+#ifdef HAXXOR_COMPACT_VERTEX
+        for(int i = 0; i < 4; i++) v[i].TexID = texId;
+#else
+        for(int i = 0; i < 4; i++) v[i].TexID = (float)texId;
+#endif
+    }
+    APP.Renderer.VerticesCount += 4;
+}
+
+static int CompareBufferIds(const void* a, const void* b)
+{
+    return (*(COMMAND_BUFFER* const*)a)->Id - (*(COMMAND_BUFFER* const*)b)->Id;
+}
+
+// Floats as unsigned integers that sort in the same order
+static uint32_t OrderedFloatBits(float x)
+{
+    uint32_t bits;
+    memcpy(&bits, &x, sizeof(bits));
+    return bits & 0x80000000u ? ~bits : bits | 0x80000000u;
+}
+
+#define COMMAND_CAMERA_SLOTS 16 // Cameras past the last slot share it, they still draw correctly but may switch more often
+
+// layer:16 | camera:4 | blend:2 | texture:26 | depth:16, so a layer is drawn in as few camera, blend mode and texture changes as possible
+// Depth only orders draws that share all of the above, use layers for anything that has to overlap correctly
+static uint64_t CommandKey(const DrawCommand* command, int cameraSlot)
+{
+    uint64_t layer = (uint16_t)(command->Layer ^ INT16_MIN);
+    uint64_t camera = (uint64_t)cameraSlot & 0xF;
+    uint64_t blend = command->Blend & 0x3;
+    uint64_t texture = command->Texture & 0x3FFFFFFu;
+    uint64_t depth = OrderedFloatBits(command->Depth) >> 16;
+    return layer << 48 | camera << 44 | blend << 42 | texture << 16 | depth;
+}
+
+// LSD radix sort on 8-bit digits, stable so equal keys keep recording order, digits every key shares are skipped
+static CommandRef* RadixSortCommands(CommandRef* refs, CommandRef* scratch, int count)
+{
+    static uint32_t histograms[8][256];
+    memset(histograms, 0, sizeof(histograms));
+    for(int i = 0; i < count; i++)
+        for(int d = 0; d < 8; d++) histograms[d][(refs[i].Key >> (d * 8)) & 0xFF]++;
+
+    for(int d = 0; d < 8; d++)
+    {
+        uint32_t* histogram = histograms[d];
+        if(histogram[(refs[0].Key >> (d * 8)) & 0xFF] == (uint32_t)count) continue;
+        uint32_t offset = 0;
+        for(int b = 0; b < 256; b++)
+        {
+            uint32_t n = histogram[b];
+            histogram[b] = offset;
+            offset += n;
+        }
+        for(int i = 0; i < count; i++) scratch[histogram[(refs[i].Key >> (d * 8)) & 0xFF]++] = refs[i];
+        CommandRef* swap = refs;
+        refs = scratch;
+        scratch = swap;
+    }
+    return refs;
+}
+
+// Submitted buffers are drawn on top of whatever the render thread drew itself this frame
+static void MergeCommandBuffers()
+{
+    MutexLock(&APP.Commands.Lock);
+    COMMAND_BUFFER* submitted = APP.Commands.Submitted;
+    APP.Commands.Submitted = NULL;
+    MutexUnlock(&APP.Commands.Lock);
+    if(submitted == NULL) return;
+
+    BLEND_MODE blend = APP.Renderer.Blend;
+    MAT4 view = APP.Renderer.ViewMatrix;
+    Bounds bounds = APP.Renderer.View;
+    // Nothing is drawn when the scratch can't grow, the buffers are still emptied below
+    bool failed = false;
+    int buffersCount = 0;
+    int commandsCount = 0;
+    for(COMMAND_BUFFER* buffer = submitted; buffer; buffer = buffer->NextSubmitted)
+    {
+        if(buffersCount == APP.Commands.BuffersCapacity)
+        {
+            int capacity = APP.Commands.BuffersCapacity ? APP.Commands.BuffersCapacity * 2 : 16;
+            COMMAND_BUFFER** buffers = realloc(APP.Commands.Buffers, capacity * sizeof(COMMAND_BUFFER*));
+            failed = buffers == NULL;
+            if(failed) break;
+            APP.Commands.Buffers = buffers;
+            APP.Commands.BuffersCapacity = capacity;
+        }
+        APP.Commands.Buffers[buffersCount++] = buffer;
+        commandsCount += buffer->Count;
+    }
+    if(!failed && commandsCount > APP.Commands.RefsCapacity)
+    {
+        // Second half is the radix sort's scratch
+        CommandRef* refs = realloc(APP.Commands.Refs, 2 * (size_t)commandsCount * sizeof(CommandRef));
+        failed = refs == NULL;
+        if(!failed)
+        {
+            APP.Commands.Refs = refs;
+            APP.Commands.RefsCapacity = commandsCount;
+        }
+    }
+
+    if(!failed && commandsCount > 0)
+    {
+        qsort(APP.Commands.Buffers, buffersCount, sizeof(COMMAND_BUFFER*), CompareBufferIds);
+        int cameras = 0;
+        for(int b = 0; b < buffersCount; b++)
+        {
+            COMMAND_BUFFER* buffer = APP.Commands.Buffers[b];
+            buffer->CameraSlot = -1;
+            for(int other = 0; other < b && buffer->CameraSlot < 0; other++)
+            {
+                if(SameCamera(buffer, APP.Commands.Buffers[other])) buffer->CameraSlot = APP.Commands.Buffers[other]->CameraSlot;
+            }
+            if(buffer->CameraSlot < 0) buffer->CameraSlot = cameras < COMMAND_CAMERA_SLOTS - 1 ? cameras++ : COMMAND_CAMERA_SLOTS - 1;
+        }
+
+        int refsCount = 0;
+        for(int b = 0; b < buffersCount; b++)
+        {
+            const COMMAND_BUFFER* buffer = APP.Commands.Buffers[b];
+            for(int i = 0; i < buffer->Count; i++)
+            {
+                const DrawCommand* command = &buffer->Commands[i];
+                // The sort is stable, keying on the buffer alone keeps each one's recording order
+                uint64_t key = APP.Commands.Sorting ? CommandKey(command, buffer->CameraSlot) : (uint64_t)b;
+                APP.Commands.Refs[refsCount++] = (CommandRef){ key, b, i };
+            }
+        }
+        CommandRef* sorted = RadixSortCommands(APP.Commands.Refs, APP.Commands.Refs + refsCount, refsCount);
+        APP.Commands.Camera = NULL;
+        for(int i = 0; i < refsCount; i++) DrawCommandQuad(APP.Commands.Buffers[sorted[i].Buffer], sorted[i].Index);
+    }
+
+    MutexLock(&APP.Commands.Lock);
+    for(COMMAND_BUFFER* buffer = submitted; buffer; buffer = buffer->NextSubmitted)
+    {
+        buffer->Count = 0;
+        buffer->Submitted = false;
+    }
+    MutexUnlock(&APP.Commands.Lock);
+    SetBlendMode(blend);
+    if(APP.Commands.Camera) UseView(view, bounds);
+    APP.Commands.Camera = NULL;
+}
+
+/** Async Loading */
+#define ASYNC_UPLOAD_CHUNK (1 << 20) // Bytes per upload
+#define ASYNC_FRAME_CHUNKS 4 // Uploads a frame can stage before spilling into the next frame's segment
+
+static void AsyncQueuePush(AsyncQueue* queue, ASYNC_TEXTURE* item)
+{
+    item->Next = NULL;
+    if(queue->Tail) queue->Tail->Next = item;
+    else queue->Head = item;
+    queue->Tail = item;
+}
+
+static ASYNC_TEXTURE* AsyncQueuePop(AsyncQueue* queue)
+{
+    ASYNC_TEXTURE* item = queue->Head;
+    if(item == NULL) return NULL;
+    queue->Head = item->Next;
+    if(queue->Head == NULL) queue->Tail = NULL;
+    return item;
+}
+
+static void AsyncQueueSplice(AsyncQueue* dst, AsyncQueue* src)
+{
+    if(src->Head == NULL) return;
+    if(dst->Tail) dst->Tail->Next = src->Head;
+    else dst->Head = src->Head;
+    dst->Tail = src->Tail;
+    src->Head = src->Tail = NULL;
+}
+
+static void FreeAsyncTexture(ASYNC_TEXTURE* tex)
+{
+    if(tex->Texture) hxglDropTexture(tex->Texture);
+    stbi_image_free(tex->Pixels);
+    free(tex->Path);
+    free(tex);
+}
+
+static THREAD_RESULT AsyncLoaderWorker(void* arg)
+{
+    (void)arg;
+    MutexLock(&APP.Loader.Lock);
+    while(true)
+    {
+        while(!APP.Loader.Quit && APP.Loader.Pending.Head == NULL) ConditionWait(&APP.Loader.Wake, &APP.Loader.Lock);
+        if(APP.Loader.Quit) break;
+        ASYNC_TEXTURE* tex = AsyncQueuePop(&APP.Loader.Pending);
+        MutexUnlock(&APP.Loader.Lock);
+
+        // A failed decode is still queued back, the render thread is the one that marks it failed
+        stbi_set_flip_vertically_on_load_thread(tex->Flip);
+        tex->Pixels = stbi_load(tex->Path, &tex->Width, &tex->Height, NULL, 4);
+
+        MutexLock(&APP.Loader.Lock);
+        AsyncQueuePush(&APP.Loader.Decoded, tex);
+    }
+    MutexUnlock(&APP.Loader.Lock);
+    return 0;
+}
+
+static bool StartAsyncLoader()
+{
+    if(!hxglLoadRingBuffer(&APP.Loader.Staging, HXGL_PIXEL_UNPACK_BUFFER, ASYNC_FRAME_CHUNKS * ASYNC_UPLOAD_CHUNK)) return false;
+    hxglDisablePixelBuffer(); // Anything left bound here would redirect every other texture upload
+    MutexInit(&APP.Loader.Lock);
+    ConditionInit(&APP.Loader.Wake);
+    APP.Loader.Quit = false;
+    // One core stays with the render thread
+    APP.Loader.WorkersCount = GetProcessorCount() - 1;
+    if(APP.Loader.WorkersCount < 1) APP.Loader.WorkersCount = 1;
+    if(APP.Loader.WorkersCount > MAXIMUM_LOADER_THREADS) APP.Loader.WorkersCount = MAXIMUM_LOADER_THREADS;
+    for(int i = 0; i < APP.Loader.WorkersCount; i++) ThreadStart(&APP.Loader.Workers[i], AsyncLoaderWorker, NULL);
+    APP.Loader.Started = true;
+    return true;
+}
+
+static void StopAsyncLoader()
+{
+    if(!APP.Loader.Started) return;
+    MutexLock(&APP.Loader.Lock);
+    APP.Loader.Quit = true;
+    ConditionBroadcast(&APP.Loader.Wake);
+    MutexUnlock(&APP.Loader.Lock);
+    for(int i = 0; i < APP.Loader.WorkersCount; i++) ThreadJoin(APP.Loader.Workers[i]);
+
+    // Handles still in flight are invalid once haxxor is shut down
+    ASYNC_TEXTURE* tex;
+    while((tex = AsyncQueuePop(&APP.Loader.Pending))) FreeAsyncTexture(tex);
+    while((tex = AsyncQueuePop(&APP.Loader.Decoded))) FreeAsyncTexture(tex);
+    while((tex = AsyncQueuePop(&APP.Loader.Uploads))) FreeAsyncTexture(tex);
+    hxglDropRingBuffer(&APP.Loader.Staging);
+    ConditionDestroy(&APP.Loader.Wake);
+    MutexDestroy(&APP.Loader.Lock);
+    APP.Loader.Started = false;
+}
+
+// Uploads one chunk worth of rows, returns true once the whole image is on the GPU
+static bool UploadAsyncChunk(ASYNC_TEXTURE* tex)
+{
+    if(tex->Texture == 0)
+    {
+        int levels = 1;
+        for(int size = tex->Width > tex->Height ? tex->Width : tex->Height; size > 1; size >>= 1) levels++;
+        tex->Texture = hxglLoadTextureStorage(tex->Width, tex->Height, levels, HXGL_LINEAR_MIPMAP_LINEAR);
+    }
+
+    int rowSize = tex->Width * 4;
+    int rows = ASYNC_UPLOAD_CHUNK / rowSize;
+    if(rows > tex->Height - tex->UploadedRows) rows = tex->Height - tex->UploadedRows;
+
+    uint8_t* staging = hxglMapRingBuffer(&APP.Loader.Staging, rows * rowSize);
+    memcpy(staging, tex->Pixels + (size_t)tex->UploadedRows * rowSize, (size_t)rows * rowSize);
+    hxglUnmapRingBuffer(&APP.Loader.Staging, rows * rowSize);
+    hxglUpdateTextureFromPixelBuffer(tex->Texture, 0, tex->UploadedRows, tex->Width, rows, APP.Loader.Staging.Buffer, hxglGetRingBufferOffset(&APP.Loader.Staging));
+    tex->UploadedRows += rows;
+    if(tex->UploadedRows < tex->Height) return false;
+
+    hxglGenerateTextureMipmaps(tex->Texture);
+    return true;
+}
+
+static void PumpAsyncUploads()
+{
+    if(!APP.Loader.Started) return;
+    MutexLock(&APP.Loader.Lock);
+    AsyncQueueSplice(&APP.Loader.Uploads, &APP.Loader.Decoded);
+    MutexUnlock(&APP.Loader.Lock);
+
+    // At least one chunk goes through every frame so a tiny budget still makes progress
+    double deadline = glfwGetTime() + APP.Loader.Budget;
+    do
+    {
+        ASYNC_TEXTURE* tex = APP.Loader.Uploads.Head;
+        if(tex == NULL) break;
+        // Rows wider than a chunk can't go through it, no GL implementation allows them anyway
+        if(tex->Released || tex->Pixels == NULL || tex->Width * 4 > ASYNC_UPLOAD_CHUNK)
+        {
+            AsyncQueuePop(&APP.Loader.Uploads);
+            if(tex->Released) FreeAsyncTexture(tex);
+            else tex->State = ASYNC_FAILED;
+            continue;
+        }
+        if(!UploadAsyncChunk(tex)) continue;
+
+        AsyncQueuePop(&APP.Loader.Uploads);
+        stbi_image_free(tex->Pixels);
+        tex->Pixels = NULL;
+        tex->State = ASYNC_READY;
+    } while(glfwGetTime() < deadline);
+    hxglAdvanceRingBuffer(&APP.Loader.Staging);
+}
+
+ASYNC_TEXTURE* LoadTextureAsync(const char* path, bool flip)
+{
+    if(!APP.Loader.Started && !StartAsyncLoader()) return NULL;
+    ASYNC_TEXTURE* tex = calloc(1, sizeof(ASYNC_TEXTURE));
+    tex->Path = malloc(strlen(path) + 1);
+    strcpy(tex->Path, path);
+    tex->Flip = flip;
+    tex->State = ASYNC_LOADING;
+
+    MutexLock(&APP.Loader.Lock);
+    AsyncQueuePush(&APP.Loader.Pending, tex);
+    ConditionBroadcast(&APP.Loader.Wake);
+    MutexUnlock(&APP.Loader.Lock);
+    return tex;
+}
+
+bool IsTextureReady(const ASYNC_TEXTURE* tex)
+{
+    return tex->State == ASYNC_READY;
+}
+
+bool IsTextureFailed(const ASYNC_TEXTURE* tex)
+{
+    return tex->State == ASYNC_FAILED;
+}
+
+TEXTURE2D GetAsyncTexture(const ASYNC_TEXTURE* tex)
+{
+    return tex->State == ASYNC_READY ? tex->Texture : 0;
+}
+
+void UnloadAsyncTexture(ASYNC_TEXTURE* tex)
+{
+    // Still owned by a worker or the upload queue, it gets freed once it comes back
+    if(tex->State == ASYNC_LOADING) tex->Released = true;
+    else FreeAsyncTexture(tex);
+}
+
+void SetAsyncUploadBudget(double milliseconds)
+{
+    APP.Loader.Budget = milliseconds / 1000.0;
+}
+
+/** Pack */
+PACK* LoadPack(const char* path)
+{
+    PACK* pack = calloc(1, sizeof(PACK));
+#ifdef _WIN32
+    pack->File = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    LARGE_INTEGER size;
+    if(pack->File == INVALID_HANDLE_VALUE || !GetFileSizeEx(pack->File, &size)) goto failed;
+    pack->Size = (size_t)size.QuadPart;
+    pack->Mapping = CreateFileMappingA(pack->File, NULL, PAGE_READONLY, 0, 0, NULL);
+    if(pack->Mapping == NULL) goto failed;
+    pack->Data = MapViewOfFile(pack->Mapping, FILE_MAP_READ, 0, 0, 0);
+    if(pack->Data == NULL) goto failed;
+#else
+    int fd = open(path, O_RDONLY);
+    struct stat info;
+    if(fd < 0) goto failed;
+    if(fstat(fd, &info) != 0)
+    {
+        close(fd);
+        goto failed;
+    }
+    pack->Size = (size_t)info.st_size;
+    void* data = mmap(NULL, pack->Size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd); // The mapping keeps the file alive
+    if(data == MAP_FAILED) goto failed;
+    pack->Data = data;
+    posix_madvise(data, pack->Size, POSIX_MADV_WILLNEED);
+#endif
+
+    pack->Header = (const HXPackHeader*)pack->Data;
+    pack->Entries = (const HXPackEntry*)(pack->Data + sizeof(HXPackHeader));
+    if(pack->Size < sizeof(HXPackHeader) || pack->Header->Magic != HXPACK_MAGIC || pack->Header->Version != HXPACK_VERSION)
+    {
+        UnloadPack(pack);
+        return NULL;
+    }
+    if(sizeof(HXPackHeader) + (uint64_t)pack->Header->EntriesCount * sizeof(HXPackEntry) > pack->Size)
+    {
+        UnloadPack(pack);
+        return NULL;
+    }
+    return pack;
+
+failed:
+    UnloadPack(pack);
+    return NULL;
+}
+
+int GetPackTextureCount(const PACK* pack)
+{
+    return (int)pack->Header->EntriesCount;
+}
+
+const char* GetPackTextureName(const PACK* pack, int index)
+{
+    return pack->Entries[index].Name;
+}
+
+#define PACK_MAXIMUM_SIDE 65536 // Past any GL_MAX_TEXTURE_SIZE, keeps the chain sizes far from overflowing
+
+// Bytes hxglLoadTextureLevels reads for the entry, false when the entry can't describe a texture
+static bool PackChainSize(const HXPackEntry* entry, uint64_t* size)
+{
+    if(entry->Width == 0 || entry->Height == 0 || entry->Width > PACK_MAXIMUM_SIDE || entry->Height > PACK_MAXIMUM_SIDE) return false;
+    uint32_t levels = 1;
+    for(uint32_t side = entry->Width > entry->Height ? entry->Width : entry->Height; side > 1; side >>= 1) levels++;
+    if(entry->Levels == 0 || entry->Levels > levels) return false;
+
+    uint64_t width = entry->Width, height = entry->Height;
+    *size = 0;
+    for(uint32_t i = 0; i < entry->Levels; i++)
+    {
+        *size += width * height * 4;
+        if(width > 1) width /= 2;
+        if(height > 1) height /= 2;
+    }
+    return true;
+}
+
+TEXTURE2D LoadTextureFromPack(const PACK* pack, const char* name)
+{
+    for(uint32_t i = 0; i < pack->Header->EntriesCount; i++)
+    {
+        const HXPackEntry* entry = &pack->Entries[i];
+        if(strncmp(entry->Name, name, HXPACK_NAME_LENGTH) != 0) continue;
+        // A truncated or corrupt pack mustn't send the upload past the mapping
+        uint64_t chain;
+        if(!PackChainSize(entry, &chain)) return 0;
+        if(entry->Offset > pack->Size || entry->Size > pack->Size - entry->Offset || entry->Size < chain) return 0;
+        // Uploaded straight from the mapped pages, the levels are already in the layout GL wants
+        int filter = entry->Levels > 1 ? HXGL_LINEAR_MIPMAP_LINEAR : HXGL_LINEAR;
+        return hxglLoadTextureLevels(pack->Data + entry->Offset, entry->Width, entry->Height, entry->Levels, filter);
+    }
+    return 0;
+}
+
+bool IsPackTexturePremultiplied(const PACK* pack, const char* name)
+{
+    for(uint32_t i = 0; i < pack->Header->EntriesCount; i++)
+    {
+        if(strncmp(pack->Entries[i].Name, name, HXPACK_NAME_LENGTH) == 0) return pack->Entries[i].Flags & HXPACK_PREMULTIPLIED;
+    }
+    return false;
+}
+
+void UnloadPack(PACK* pack)
+{
+#ifdef _WIN32
+    if(pack->Data) UnmapViewOfFile(pack->Data);
+    if(pack->Mapping) CloseHandle(pack->Mapping);
+    if(pack->File && pack->File != INVALID_HANDLE_VALUE) CloseHandle(pack->File);
+#else
+    if(pack->Data) munmap((void*)pack->Data, pack->Size);
+#endif
+    free(pack);
+}
+
+/** Atlas */
+#define ATLAS_PADDING 1 // Border texels extruded around every region, linear filtering at its edge only sees its own texels
+
+ATLAS* LoadAtlas(int width, int height)
+{
+    ATLAS* atlas = malloc(sizeof(ATLAS));
+    if(atlas == NULL) return NULL;
+    atlas->Width = width;
+    atlas->Height = height;
+    atlas->Pages = NULL;
+    atlas->PagesCount = 0;
+    return atlas;
+}
+
+static AtlasPage* AddAtlasPage(ATLAS* atlas)
+{
+    AtlasPage* pages = realloc(atlas->Pages, sizeof(AtlasPage) * (atlas->PagesCount + 1));
+    if(pages == NULL) return NULL;
+    atlas->Pages = pages;
+    AtlasNode* nodes = malloc(sizeof(AtlasNode) * (atlas->Width + 1));
+    if(nodes == NULL) return NULL;
+    AtlasPage* page = &atlas->Pages[atlas->PagesCount++];
+    // Regions are sampled without mipmaps, otherwise the lower levels blend regions together
+    page->Texture = hxglLoadTexture(NULL, atlas->Width, atlas->Height, HXGL_LINEAR);
+    page->Nodes = nodes;
+    page->Nodes[0] = (AtlasNode){ 0, 0, atlas->Width };
+    page->NodesCount = 1;
+    return page;
+}
+
+// Returns the lowest y a w wide rectangle can sit at when its left edge is on node i, or -1 when it doesn't fit
+static int FitAtlasNode(const ATLAS* atlas, const AtlasPage* page, int i, int w, int h)
+{
+    int x = page->Nodes[i].X;
+    if(x + w > atlas->Width) return -1;
+    int y = 0;
+    for(int remaining = w; remaining > 0; i++)
+    {
+        if(page->Nodes[i].Y > y) y = page->Nodes[i].Y;
+        if(y + h > atlas->Height) return -1;
+        remaining -= page->Nodes[i].Width;
+    }
+    return y;
+}
+
+static bool PackAtlasPage(const ATLAS* atlas, AtlasPage* page, int w, int h, int* outX, int* outY)
+{
+    int best = -1, bestX = 0, bestY = atlas->Height, bestWidth = atlas->Width + 1;
+    for(int i = 0; i < page->NodesCount; i++)
+    {
+        int y = FitAtlasNode(atlas, page, i, w, h);
+        if(y < 0) continue;
+        // Bottom-left rule, the narrowest node breaks ties so wide gaps stay open for wide images
+        if(y < bestY || (y == bestY && page->Nodes[i].Width < bestWidth))
+        {
+            best = i;
+            bestX = page->Nodes[i].X;
+            bestY = y;
+            bestWidth = page->Nodes[i].Width;
+        }
+    }
+    if(best < 0) return false;
+
+    // The new node covers [bestX, bestX + w), shrink or drop the nodes it shadows
+    memmove(&page->Nodes[best + 1], &page->Nodes[best], sizeof(AtlasNode) * (page->NodesCount - best));
+    page->Nodes[best] = (AtlasNode){ bestX, bestY + h, w };
+    page->NodesCount++;
+    for(int i = best + 1; i < page->NodesCount; i++)
+    {
+        AtlasNode* node = &page->Nodes[i];
+        int shadow = bestX + w - node->X;
+        if(shadow <= 0) break;
+        if(shadow < node->Width)
+        {
+            node->X += shadow;
+            node->Width -= shadow;
+            break;
+        }
+        memmove(node, node + 1, sizeof(AtlasNode) * (page->NodesCount - i - 1));
+        page->NodesCount--;
+        i--;
+    }
+    for(int i = 0; i + 1 < page->NodesCount; i++)
+    {
+        if(page->Nodes[i].Y != page->Nodes[i + 1].Y) continue;
+        page->Nodes[i].Width += page->Nodes[i + 1].Width;
+        memmove(&page->Nodes[i + 1], &page->Nodes[i + 2], sizeof(AtlasNode) * (page->NodesCount - i - 2));
+        page->NodesCount--;
+        i--;
+    }
+
+    *outX = bestX;
+    *outY = bestY;
+    return true;
+}
+
+// Copy of the image with its edge texels repeated ATLAS_PADDING times on every side
+static uint8_t* ExtrudeImage(const IMAGE* image)
+{
+    int w = image->Width + 2 * ATLAS_PADDING, h = image->Height + 2 * ATLAS_PADDING;
+    uint8_t* block = malloc((size_t)w * h * 4);
+    if(block == NULL) return NULL;
+    for(int y = 0; y < h; y++)
+    {
+        int sy = y < ATLAS_PADDING ? 0 : y - ATLAS_PADDING < image->Height ? y - ATLAS_PADDING : image->Height - 1;
+        const uint8_t* src = (const uint8_t*)image->Data + (size_t)sy * image->Width * 4;
+        uint8_t* dst = block + (size_t)y * w * 4;
+        memcpy(dst + ATLAS_PADDING * 4, src, (size_t)image->Width * 4);
+        for(int x = 0; x < ATLAS_PADDING; x++)
+        {
+            memcpy(dst + x * 4, src, 4);
+            memcpy(dst + (size_t)(w - 1 - x) * 4, src + (size_t)(image->Width - 1) * 4, 4);
+        }
+    }
+    return block;
+}
+
+ATLAS_REGION AddAtlasImage(ATLAS* atlas, const IMAGE* image)
+{
+    ATLAS_REGION region = {0};
+    int w = image->Width + 2 * ATLAS_PADDING, h = image->Height + 2 * ATLAS_PADDING;
+    if(w > atlas->Width || h > atlas->Height) return region;
+    uint8_t* block = ExtrudeImage(image);
+    if(block == NULL) return region;
+
+    // Earlier pages are tried first so the small images fill the gaps the big ones left
+    int x = 0, y = 0;
+    AtlasPage* page = NULL;
+    for(int i = 0; i < atlas->PagesCount && page == NULL; i++)
+    {
+        if(PackAtlasPage(atlas, &atlas->Pages[i], w, h, &x, &y)) page = &atlas->Pages[i];
+    }
+    ReleaseTextureSlots();
+    if(page == NULL)
+    {
+        page = AddAtlasPage(atlas);
+        if(page == NULL || !PackAtlasPage(atlas, page, w, h, &x, &y))
+        {
+            free(block);
+            return region;
+        }
+    }
+
+    hxglUpdateTexture(page->Texture, x, y, w, h, block);
+    free(block);
+    region.Texture = page->Texture;
+    region.Uv.x = (float)(x + ATLAS_PADDING) / atlas->Width;
+    region.Uv.y = (float)(y + ATLAS_PADDING) / atlas->Height;
+    region.Uv.w = (float)image->Width / atlas->Width;
+    region.Uv.h = (float)image->Height / atlas->Height;
+    return region;
+}
+
+void DestroyAtlas(ATLAS* atlas)
+{
+    for(int i = 0; i < atlas->PagesCount; i++)
+    {
+        hxglDropTexture(atlas->Pages[i].Texture);
+        free(atlas->Pages[i].Nodes);
+    }
+    free(atlas->Pages);
+    free(atlas);
+}
@@ -0,0 +1,200 @@
+/***
+ * Bakes images into a texture pack (see "hxpack.h").
+ * usage: bake [-premultiply] [-nomips] <output> <image>...
+ */
+
+#include <hxpack.h>
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static uint32_t CountLevels(uint32_t width, uint32_t height)
+{
+	uint32_t levels = 1;
+	for(uint32_t size = width > height ? width : height; size > 1; size >>= 1) levels++;
+	return levels;
+}
+
+// 2x2 box filter, on an odd side the last box also takes the extra row or column so no texel is dropped
+static void Downsample(const uint8_t* src, uint32_t sw, uint32_t sh, uint8_t* dst, uint32_t dw, uint32_t dh)
+{
+	for(uint32_t y = 0; y < dh; y++)
+	{
+		uint32_t y0 = y * 2, y1 = y + 1 == dh ? sh - 1 : y * 2 + 1;
+		for(uint32_t x = 0; x < dw; x++)
+		{
+			uint32_t x0 = x * 2, x1 = x + 1 == dw ? sw - 1 : x * 2 + 1;
+			uint32_t count = (y1 - y0 + 1) * (x1 - x0 + 1);
+			for(int c = 0; c < 4; c++)
+			{
+				uint32_t sum = 0;
+				for(uint32_t sy = y0; sy <= y1; sy++)
+					for(uint32_t sx = x0; sx <= x1; sx++) sum += src[(sy * sw + sx) * 4 + c];
+				dst[(y * dw + x) * 4 + c] = (uint8_t)((sum + count / 2) / count);
+			}
+		}
+	}
+}
+
+static void Premultiply(uint8_t* pixels, uint32_t count)
+{
+	for(uint32_t i = 0; i < count; i++)
+	{
+		uint8_t* p = pixels + i * 4;
+		for(int c = 0; c < 3; c++) p[c] = (uint8_t)((p[c] * p[3] + 127) / 255);
+	}
+}
+
+static uint64_t Align(uint64_t offset)
+{
+	return (offset + HXPACK_ALIGNMENT - 1) & ~(uint64_t)(HXPACK_ALIGNMENT - 1);
+}
+
+// The file is written front to back, so no seek ever needs an offset past what a long holds
+static void WriteZeros(FILE* file, uint64_t count)
+{
+	static const uint8_t zeros[256];
+	while(count > 0)
+	{
+		size_t chunk = count < sizeof(zeros) ? (size_t)count : sizeof(zeros);
+		fwrite(zeros, 1, chunk, file);
+		count -= chunk;
+	}
+}
+
+// Writes the entry's whole mip chain at the current end of the file and returns its size
+static uint64_t WriteLevels(FILE* file, uint8_t* pixels, const HXPackEntry* entry)
+{
+	uint64_t size = 0;
+	uint32_t lw = entry->Width, lh = entry->Height;
+	uint8_t* level = pixels;
+	for(uint32_t l = 0; l < entry->Levels; l++)
+	{
+		fwrite(level, 4, (size_t)lw * lh, file);
+		size += (uint64_t)lw * lh * 4;
+		if(l + 1 == entry->Levels) break;
+		uint32_t nw = lw > 1 ? lw / 2 : 1, nh = lh > 1 ? lh / 2 : 1;
+		uint8_t* next = malloc((size_t)nw * nh * 4);
+		if(next == NULL)
+		{
+			size = 0;
+			break;
+		}
+		Downsample(level, lw, lh, next, nw, nh);
+		if(level != pixels) free(level);
+		level = next;
+		lw = nw;
+		lh = nh;
+	}
+	if(level != pixels) free(level);
+	return size;
+}
+
+int main(int argc, char** argv)
+{
+	bool premultiply = false, mips = true;
+	int arg = 1;
+	for(; arg < argc && argv[arg][0] == '-'; arg++)
+	{
+		if(strcmp(argv[arg], "-premultiply") == 0) premultiply = true;
+		else if(strcmp(argv[arg], "-nomips") == 0) mips = false;
+		else
+		{
+			fprintf(stderr, "Unknown option %s\n", argv[arg]);
+			return 1;
+		}
+	}
+	if(argc - arg < 2)
+	{
+		fprintf(stderr, "usage: %s [-premultiply] [-nomips] <output> <image>...\n", argv[0]);
+		return 1;
+	}
+
+	const char* output = argv[arg++];
+	uint32_t count = (uint32_t)(argc - arg);
+	HXPackHeader header = { HXPACK_MAGIC, HXPACK_VERSION, count, 0 };
+	// Baked next to the output and renamed over it once complete, a failed bake leaves the old pack alone
+	char* temp = malloc(strlen(output) + 5);
+	HXPackEntry* entries = calloc(count, sizeof(HXPackEntry));
+	if(temp == NULL || entries == NULL)
+	{
+		fprintf(stderr, "Out of memory\n");
+		free(temp);
+		free(entries);
+		return 1;
+	}
+	sprintf(temp, "%s.tmp", output);
+	FILE* file = fopen(temp, "wb");
+	if(file == NULL)
+	{
+		fprintf(stderr, "Failed to open %s\n", temp);
+		free(temp);
+		free(entries);
+		return 1;
+	}
+
+	// The table is rewritten last, once every offset is known
+	uint64_t offset = sizeof(HXPackHeader) + sizeof(HXPackEntry) * count;
+	WriteZeros(file, offset);
+	bool ok = true;
+	for(uint32_t i = 0; i < count && ok; i++)
+	{
+		const char* path = argv[arg + i];
+		int w, h;
+		uint8_t* pixels = stbi_load(path, &w, &h, NULL, 4);
+		if(pixels == NULL)
+		{
+			fprintf(stderr, "Failed to decode %s: %s\n", path, stbi_failure_reason());
+			ok = false;
+			break;
+		}
+		if(premultiply) Premultiply(pixels, (uint32_t)(w * h));
+
+		HXPackEntry* entry = &entries[i];
+		strncpy(entry->Name, path, HXPACK_NAME_LENGTH - 1);
+		entry->Width = (uint32_t)w;
+		entry->Height = (uint32_t)h;
+		entry->Levels = mips ? CountLevels(entry->Width, entry->Height) : 1;
+		entry->Flags = premultiply ? HXPACK_PREMULTIPLIED : 0;
+		entry->Offset = Align(offset);
+		WriteZeros(file, entry->Offset - offset);
+		entry->Size = WriteLevels(file, pixels, entry);
+		stbi_image_free(pixels);
+		if(entry->Size == 0)
+		{
+			fprintf(stderr, "Out of memory baking %s\n", path);
+			ok = false;
+			break;
+		}
+		offset = entry->Offset + entry->Size;
+		printf("Baked %s (%ux%u, %u levels)\n", path, entry->Width, entry->Height, entry->Levels);
+	}
+
+	if(ok)
+	{
+		fseek(file, 0, SEEK_SET);
+		fwrite(&header, sizeof(HXPackHeader), 1, file);
+		fwrite(entries, sizeof(HXPackEntry), count, file);
+		if(ferror(file))
+		{
+			fprintf(stderr, "Failed to write %s\n", temp);
+			ok = false;
+		}
+	}
+	if(fclose(file) != 0) ok = false;
+	free(entries);
+#ifdef _WIN32
+	if(ok) remove(output); // rename doesn't replace an existing file on Windows
+#endif
+	if(ok && rename(temp, output) != 0)
+	{
+		fprintf(stderr, "Failed to rename %s to %s\n", temp, output);
+		ok = false;
+	}
+	if(!ok) remove(temp);
+	free(temp);
+	return ok ? 0 : 1;
+}